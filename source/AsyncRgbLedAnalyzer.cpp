@@ -4,10 +4,27 @@
 
 #include <AnalyzerChannelData.h>
 
-#include <iostream>
 #include <algorithm> // for std::max/max()
+#include <chrono>
 
-//#define LED_LOGGING
+namespace
+{
+    // most edges read from the channel data before they are decoded
+    const size_t CHANNEL_READ_EDGES = 4096;
+
+    // edges collected for each decode thread before a batch of segments
+    // is decoded in parallel
+    const size_t SEGMENT_BATCH_EDGES_PER_THREAD = 1 << 16;
+
+    // in live mode, decoding skips ahead once it is this many latency
+    // targets behind the capture
+    const double LIVE_MAX_LAG_LATENCIES = 4.0;
+
+    double LiveClockSeconds()
+    {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+}
 
 AsyncRgbLedAnalyzer::AsyncRgbLedAnalyzer()
     :   Analyzer2(),
@@ -31,331 +48,725 @@ void AsyncRgbLedAnalyzer::SetupResults()
 void AsyncRgbLedAnalyzer::WorkerThread()
 {
     mSampleRateHz = GetSampleRate();
-    mHalfSampleWidth = 0.5 / mSampleRateHz;
     mChannelData = GetAnalyzerChannelData( mSettings->mInputChannel );
 
-    // cache this value here to avoid recomputing this every bit-read
-    if ( mSettings->IsHighSpeedSupported() )
-    {
-        mMinimumLowDurationSec = std::min( mSettings->DataTiming( BIT_LOW, true ).mNegativeTiming.mMinimumSec,
-                                           mSettings->DataTiming( BIT_HIGH, true ).mNegativeTiming.mMinimumSec );
-    }
-    else
-    {
-        mMinimumLowDurationSec = std::min( mSettings->DataTiming( BIT_LOW ).mNegativeTiming.mMinimumSec,
-                                           mSettings->DataTiming( BIT_HIGH ).mNegativeTiming.mMinimumSec );
-    }
+    // convert all the controller timing to samples once, so reading a bit
+    // doesn't need any floating-point math or settings lookups
+    mTiming = mSettings->SampleTiming( mSampleRateHz );
 
-    mMinimumLowDurationSec-= mHalfSampleWidth;
+    const double liveLatencySec = mSettings->mLiveLatencyMs * 1e-3;
+    mIsLive = ( mSettings->mLiveLatencyMs > 0 );
+    mLiveLatencySamples = std::max<U64>( 1, static_cast<U64>( liveLatencySec * mSampleRateHz ) );
+    mLiveLag.Configure( mSampleRateHz, LIVE_MAX_LAG_LATENCIES * liveLatencySec );
+    mLiveLag.Start();
 
-    bool isResyncNeeded = true;
+    double commitIntervalSamples = std::max( 0.0, mSettings->mCommitIntervalSec * mSampleRateHz );
 
-    for ( ; ; )
+    if ( mIsLive )
     {
-        if ( isResyncNeeded )
-        {
-            SynchronizeToReset();
-            isResyncNeeded = false;
-        }
+        commitIntervalSamples = std::min( commitIntervalSamples, static_cast<double>( mLiveLatencySamples ) );
+    }
 
-        mFirstBitAfterReset = true;
-        U32 frameInPacketIndex = 0;
-        mResults->CommitPacketAndStartNewPacket();
+    mCommitPolicy.Configure( mSettings->mCommitFrameCount, static_cast<U64>( commitIntervalSamples ) );
 
-        // data word reading loop
-        for ( ; ; )
-        {
-            auto result = ReadRGBTriple();
+    mIsPacketMode = ( mSettings->mResultsMode == AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET );
+    mIsRunLengthMode = ( mSettings->mResultsMode == AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH );
+    mIsTimelineMode = ( mSettings->mResultsMode == AsyncRgbLedAnalyzerSettings::RESULTS_TIMELINE );
+    mRun.mIsActive = false;
+    mIsPacketOpen = false;
+    mPacketSequence = 0;
+    mPacketIndex.Clear();
+    mColorArena.Clear( mSettings->BitSize() );
+    mLazyPackets.Clear( mTiming, mSettings->BitSize(), mSettings->GetColorLayout() );
+    mPacketColors.clear();
 
-            if ( result.mValid )
-            {
-                Frame frame;
-                frame.mFlags = 0;
-                frame.mStartingSampleInclusive = result.mValueBeginSample;
-                frame.mEndingSampleInclusive = result.mValueEndSample;
-                frame.mData1 = result.mRGB.ConvertToU64();
-                frame.mData2 = frameInPacketIndex++;
-                mResults->AddFrame( frame );
-                mResults->CommitResults();
-            }
-            else
-            {
-#if defined(LED_LOGGING)
-                std::cerr << "failed to read frame at:" << (frameInPacketIndex) << std::endl;
-#endif
-                // something error occurred, let's resynchronise
-                isResyncNeeded = true;
-            }
+    if ( mIsTimelineMode )
+    {
+        // the colors are decoded while the timeline is scanned
+        mLazyPackets.StartBackgroundDecode();
+    }
 
-            if ( isResyncNeeded || result.mIsReset )
-            {
-                break;
-            }
-        }
+    // start at a low level; if the signal is low already, the start of the
+    // capture acts as the first falling edge
+    if ( mChannelData->GetBitState() == BIT_HIGH )
+    {
+        mChannelData->AdvanceToNextEdge();
+    }
+
+    mChannelLevel = BIT_LOW;
+    mChannelInReset = false;
+    mChannelSample = mChannelData->GetSampleNumber();
+    mCommitPolicy.Start( mChannelSample );
+    StartEdgeCache();
 
-        mResults->CommitResults();
-        ReportProgress( mChannelData->GetSampleNumber() );
+    if ( mIsTimelineMode )
+    {
+        ScanTimeline();
+    }
+    else if ( ( mSettings->mDecodeThreadCount > 1 ) && !mIsLive )
+    {
+        DecodeSegmentsInParallel();
+    }
+    else
+    {
+        DecodeChannel();
     }
 }
 
-void AsyncRgbLedAnalyzer::SynchronizeToReset()
+void AsyncRgbLedAnalyzer::StartEdgeCache()
 {
-    if ( mChannelData->GetBitState() == BIT_HIGH )
+    // cached edges are only reused for the same capture: the channel,
+    // sample rate, trigger sample and start sample have to match, and so
+    // do the first edges of the channel data. The rest of the cache is
+    // checked against the channel data as it is replayed.
+    const U64 triggerSample = GetTriggerSample();
+    const U64 maxBytes = static_cast<U64>( mSettings->mEdgeCacheMiB ) << 20;
+    const size_t cacheBytes = static_cast<size_t>( std::min<U64>( maxBytes, std::numeric_limits<size_t>::max() ) );
+    const bool isSameKey = ( mEdgeCache.MaxBytes() == cacheBytes ) &&
+                           ( mEdgeCacheChannel == mSettings->mInputChannel ) &&
+                           ( mEdgeCacheSampleRateHz == mSampleRateHz ) &&
+                           ( mEdgeCacheTriggerSample == triggerSample ) &&
+                           ( mEdgeCache.StartSample() == mChannelSample );
+
+    if ( !isSameKey )
     {
-        mChannelData->AdvanceToNextEdge();
+        // the cached edges can't be used, so don't hold on to them while
+        // the new ones are read
+        mEdgeCache = EdgeCache( cacheBytes );
+        mEdgeCache.Clear( mChannelSample );
     }
 
-    for ( ; ; )
-    {
-        const U64 lowTransition = mChannelData->GetSampleNumber();
-        const U64 highTransition = mChannelData->GetSampleOfNextEdge();
-        double lowTimeSec = ( highTransition - lowTransition ) / mSampleRateHz;
+    mCacheReader = EdgeCache::Reader( mEdgeCache );
+    bool isSameCapture = isSameKey && mCacheReader.HasNext();
+    mChannelEdges.clear();
 
-        if ( lowTimeSec > (mSettings->ResetTiming().mMinimumSec - mHalfSampleWidth))
+    while ( isSameCapture && mCacheReader.HasNext() && ( mChannelEdges.size() < CHANNEL_READ_EDGES ) )
+    {
+        if ( !mChannelEdges.empty() && !mChannelData->DoMoreTransitionsExistInCurrentData() )
         {
-            // it's a reset, we are done
-            // advance to the end of the reset, ready for the first
-            // ReadRGB / ReadBit
-            mChannelData->AdvanceToAbsPosition( highTransition );
-            return;
+            // the capture so far might be the start of a different one
+            isSameCapture = false;
+            break;
         }
 
-        // advance past the rising edge, to the next falling edge,
-        // which is our next candidate for the beginning of a RESET
-        mChannelData->AdvanceToAbsPosition( highTransition );
         mChannelData->AdvanceToNextEdge();
+        mChannelEdges.push_back( mChannelData->GetSampleNumber() );
+        isSameCapture = ( mChannelEdges.back() == mCacheReader.Peek() );
+        mCacheReader.Next();
     }
+
+    if ( !isSameCapture )
+    {
+        // cache the edges read while checking, so they are decoded from
+        // the cache like any others
+        mEdgeCache.Clear( mChannelSample );
+        mEdgeCache.Append( mChannelEdges.data(), mChannelEdges.size() );
+        mEdgeCacheChannel = mSettings->mInputChannel;
+        mEdgeCacheSampleRateHz = mSampleRateHz;
+        mEdgeCacheTriggerSample = triggerSample;
+    }
+
+    // the channel data is read again after the last cached edge, which is
+    // never before the edges read here
+    mCacheReader = EdgeCache::Reader( mEdgeCache );
+    mIsReplayingCache = mCacheReader.HasNext();
+    mIsCachingEdges = true;
 }
 
-auto AsyncRgbLedAnalyzer::ReadRGBTriple() -> RGBResult
+bool AsyncRgbLedAnalyzer::ReadChannelEdges()
 {
-    const U8 bitSize =  mSettings->BitSize();
-    U16 channels[3] = {0, 0, 0};
-    RGBResult result;
+    mChannelEdges.clear();
 
-    DataBuilder builder;
-    int channel = 0;
+    if ( mIsReplayingCache )
+    {
+        if ( ReadCachedEdges() )
+        {
+            return true;
+        }
 
-    for ( ; channel < 3; )
-{
-U64 value = 0;
-builder.Reset( &value, AnalyzerEnums::MsbFirst, bitSize );
-    int i = 0;
+        if ( !mChannelEdges.empty() )
+        {
+            return false;
+        }
+    }
+
+    bool isReset = false;
 
-    for ( ; i < bitSize; ++i )
+    while ( mChannelEdges.size() < CHANNEL_READ_EDGES )
     {
-        auto bitResult = ReadBit();
+        if ( ( mChannelLevel == BIT_LOW ) && !mChannelInReset &&
+                !mChannelData->WouldAdvancingCauseTransition( mTiming.mResetSamples ) )
+        {
+            // this low period is a reset. Stop here, so everything before the
+            // reset can be decoded without waiting for the next packet to arrive.
+            mChannelInReset = true;
+            isReset = true;
+            break;
+        }
+
+        const bool isCaughtUp = !mChannelData->DoMoreTransitionsExistInCurrentData();
 
-        if ( !bitResult.mValid )
+        if ( isCaughtUp && !mChannelEdges.empty() )
         {
-#if defined(LED_LOGGING)
-            std::cerr << "RGB read failure at bit " << i << std::endl;
-#endif
+            // don't wait for more of the capture while holding edges which
+            // can be decoded already
             break;
         }
 
-        // for the first bit of channel 0, record the beginning time
-        // for accurate frame positions in the results
-        if ( ( i == 0 ) && ( channel == 0 ) )
+        if ( mIsLive && !mChannelEdges.empty() && ( mChannelSample - mChannelEdges.front() >= mLiveLatencySamples ) )
         {
-            result.mValueBeginSample = bitResult.mBeginSample;
+            break;
         }
 
-        result.mValueEndSample = bitResult.mEndSample;
-        builder.AddBit( bitResult.mBitValue );
-        result.mIsReset = bitResult.mIsReset;
+        mChannelData->AdvanceToNextEdge();
+        mChannelSample = mChannelData->GetSampleNumber();
+        mChannelEdges.push_back( mChannelSample );
+        mChannelLevel = ( mChannelLevel == BIT_LOW ) ? BIT_HIGH : BIT_LOW;
+        mChannelInReset = false;
+
+        if ( isCaughtUp && mIsLive )
+        {
+            // this edge was waited for, so it is about the newest sample
+            mLiveLag.CaughtUp( mChannelSample, LiveClockSeconds() );
+        }
     }
 
-    if ( i == bitSize )
+    if ( mIsCachingEdges )
     {
-        // we saw a complete channel, save it
-        channels[channel++] = value;
+        mEdgeCache.Append( mChannelEdges.data(), mChannelEdges.size() );
     }
-    else
+
+    return isReset;
+}
+
+bool AsyncRgbLedAnalyzer::ReadCachedEdges()
+{
+    // the channel data is checked against the cache at every reset, before
+    // it ends a packet, and after every block of edges. From the first
+    // difference on, the channel data is read instead. A capture is only
+    // taken for the same one if it has the same edges at all these points.
+    while ( mCacheReader.HasNext() && ( mChannelEdges.size() < CHANNEL_READ_EDGES ) )
+    {
+        const U64 edgeSample = mCacheReader.Peek();
+
+        // the same rule as for the channel data: a low period longer than
+        // the reset time
+        if ( ( mChannelLevel == BIT_LOW ) && !mChannelInReset && ( edgeSample - mChannelSample > mTiming.mResetSamples ) )
+        {
+            if ( !IsCacheInChannel() )
+            {
+                DropEdgeCache();
+                return false;
+            }
+
+            mChannelInReset = true;
+            return true;
+        }
+
+        mCacheReader.Next();
+        mChannelEdges.push_back( edgeSample );
+        mChannelSample = edgeSample;
+        mChannelLevel = ( mChannelLevel == BIT_LOW ) ? BIT_HIGH : BIT_LOW;
+        mChannelInReset = false;
+    }
+
+    if ( !IsCacheInChannel() )
     {
-        // partial data due to reset or invalid timing, discard
-        break;
+        DropEdgeCache();
     }
+    else if ( !mCacheReader.HasNext() )
+    {
+        // carry on reading the channel data from the last cached edge
+        mIsReplayingCache = false;
+    }
+
+    return false;
 }
 
-if ( channel == 3 )
+void AsyncRgbLedAnalyzer::DropEdgeCache()
 {
-// we saw three complete channels, we can use this
-result.mRGB = RGBValue::CreateFromControllerOrder( mSettings->GetColorLayout(), channels );
-    result.mValid = true;
-} // in all other cases, mValid stays false - no RGB data was written
+    // the capture changed since it was cached: read the rest of it from
+    // the channel data, and cache it afresh when analysis runs again
+    mChannelLevel = mChannelData->GetBitState();
+    mIsReplayingCache = false;
+    mIsCachingEdges = false;
+    mCacheReader = EdgeCache::Reader();
+    mEdgeCache.Clear( mEdgeCache.StartSample() );
+}
 
-return result;
+bool AsyncRgbLedAnalyzer::IsCacheInChannel()
+{
+    // edges up to the read position were checked when the cache was started
+    if ( mChannelSample < mChannelData->GetSampleNumber() )
+    {
+        return true;
+    }
+
+    mChannelData->AdvanceToAbsPosition( mChannelSample );
+
+    if ( mChannelData->GetBitState() != mChannelLevel )
+    {
+        return false;
+    }
+
+    if ( !mCacheReader.HasNext() )
+    {
+        return true;
+    }
+
+    // a capture which doesn't reach the next cached edge yet is a different one
+    return mChannelData->DoMoreTransitionsExistInCurrentData() &&
+           ( mChannelData->GetSampleOfNextEdge() == mCacheReader.Peek() );
 }
 
-auto AsyncRgbLedAnalyzer::ReadBit() -> ReadResult
+void AsyncRgbLedAnalyzer::DecodeChannel()
 {
-    ReadResult result;
-    result.mValid = false;
+    std::unique_ptr<LedDecoder> decoder = LedDecoder::Create( mTiming, mSettings->BitSize(), mSettings->GetColorLayout() );
+    decoder->Start( mChannelSample, this );
 
-    if ( mChannelData->GetBitState() == BIT_LOW )
+    for ( ; ; )
     {
-        mChannelData->AdvanceToNextEdge();
+        const bool isReset = ReadChannelEdges();
+        decoder->Push( mChannelEdges.data(), mChannelEdges.size() );
+
+        if ( isReset )
+        {
+            decoder->Idle( mChannelSample + mTiming.mResetSamples );
+        }
+
+        if ( mIsLive )
+        {
+            CommitLiveResults();
+
+            if ( mLiveLag.IsBehind( mChannelSample, LiveClockSeconds() ) || ( mChannelSample >= mForcedSkipSample ) )
+            {
+                SkipToNewestSample( *decoder );
+            }
+        }
+        else if ( IsCaughtUp() )
+        {
+            CommitCaughtUpResults();
+        }
     }
+}
 
-    result.mBeginSample = mChannelData->GetSampleNumber();
-    mChannelData->AdvanceToNextEdge();
-    const U64 fallingEdgeSample = mChannelData->GetSampleNumber();
-    const double highTimeSec = ( fallingEdgeSample - result.mBeginSample ) / mSampleRateHz;
+void AsyncRgbLedAnalyzer::ScanTimeline()
+{
+    // packets start at the first rising edge after a reset
+    bool isSynchronized = false;
+    bool isPacketStarted = false;
+    bool isLow = true;
+    U64 lastEdgeSample = mChannelSample;
+    U64 beginSample = 0;
 
- //   std::cout << "hi time:" << highTimeSec << " (" << ( fallingEdgeSample - result.mBeginSample ) << ")" << std::endl;
-    if ( mFirstBitAfterReset )
+    for ( ; ; )
     {
-        // we can't classify yet, need to wait until we have the low pulse timing
+        const bool isReset = ReadChannelEdges();
+
+        // collect the pulse lengths up to the next reset, without
+        // classifying any bits
+        for ( const U64 edgeSample : mChannelEdges )
+        {
+            if ( !isSynchronized )
+            {
+                // waiting for the first reset
+            }
+            else if ( isLow && !isPacketStarted )
+            {
+                beginSample = edgeSample;
+                isPacketStarted = true;
+            }
+            else
+            {
+                mPacketPulses.push_back( ClampToU32( edgeSample - lastEdgeSample ) );
+            }
+
+            lastEdgeSample = edgeSample;
+            isLow = !isLow;
+        }
+
+        if ( isReset && isPacketStarted )
+        {
+            // the reset is the low pulse of the last bit
+            mPacketPulses.push_back( ClampToU32( mTiming.mResetSamples + 1 ) );
+        }
+
+        mLazyPackets.AppendPulses( mPacketPulses.data(), mPacketPulses.size() );
+        mPacketPulses.clear();
+
+        if ( mIsLive )
+        {
+            CommitLiveResults();
+        }
+
+        if ( !isReset )
+        {
+            continue;
+        }
+
+        if ( isPacketStarted )
+        {
+            const U32 ledCount = mLazyPackets.OpenPacketLedCount();
+
+            if ( ledCount > 0 )
+            {
+                // a packet too long to store is cut short, like one ending in an error
+                const U8 flags = mLazyPackets.IsOpenPacketTruncated() ?
+                                 static_cast<U8>( FRAME_FLAG_PACKET_ERROR | DISPLAY_AS_WARNING_FLAG ) : 0;
+                const U64 packet = mLazyPackets.EndPacket();
+                AddResultFrame( FRAME_FLAG_PACKET | FRAME_FLAG_LAZY | flags, beginSample, lastEdgeSample, packet, ledCount );
+                mCurrentPacket.mLedCount = ledCount;
+                mPacketIndex.Add( mCurrentPacket );
+            }
+            else
+            {
+                mLazyPackets.DiscardPacket();
+            }
+
+            if ( mCommitPolicy.EndPacket( lastEdgeSample ) )
+            {
+                CommitPendingResults( lastEdgeSample );
+            }
+        }
+
+        isSynchronized = true;
+        isPacketStarted = false;
+        mResults->CommitPacketAndStartNewPacket();
+        ++mPacketSequence;
+        mCurrentPacket.mFrameCount = 0;
     }
-    else
+}
+
+void AsyncRgbLedAnalyzer::DecodeSegmentsInParallel()
+{
+    const size_t threadCount = mSettings->mDecodeThreadCount;
+    const size_t batchEdgeCount = threadCount * SEGMENT_BATCH_EDGES_PER_THREAD;
+
+    // the threads wait between batches, and are stopped by the next analysis
+    mSegmentPool.Start( mTiming, mSettings->BitSize(), mSettings->GetColorLayout(), threadCount );
+
+    // the offset of each segment waiting to be decoded, and then of the
+    // segment being read. Each segment runs from the falling edge starting
+    // one reset to the falling edge starting the next.
+    mSegmentEdges.assign( 1, mChannelSample );
+    mSegmentOffsets.assign( 1, 0 );
+    mSegmentStream.Clear();
+
+    for ( ; ; )
     {
-        // clasify based on existing value
-        // ensure consistency with previously detected speed setting
-        if ( mSettings->DataTiming( BIT_LOW, mDidDetectHighSpeed ).mPositiveTiming.WithinTolerance( highTimeSec, mHalfSampleWidth ) )
+        const bool isReset = ReadChannelEdges();
+        const bool isCaughtUp = IsCaughtUp();
+
+        if ( mSegmentStream.IsActive() )
         {
-            result.mBitValue = BIT_LOW;
+            // a segment too long for a batch is decoded as it is read, on
+            // this thread, and batches start again after its reset
+            mSegmentStream.Push( mChannelEdges.data(), mChannelEdges.size() );
+
+            if ( isReset )
+            {
+                mSegmentStream.Finish( mChannelSample + mTiming.mResetSamples );
+                mSegmentEdges.assign( 1, mChannelSample );
+            }
+
+            if ( isCaughtUp )
+            {
+                CommitCaughtUpResults();
+            }
+
+            continue;
         }
-        else if ( mSettings->DataTiming( BIT_HIGH, mDidDetectHighSpeed ).mPositiveTiming.WithinTolerance( highTimeSec, mHalfSampleWidth ) )
+
+        mSegmentEdges.insert( mSegmentEdges.end(), mChannelEdges.begin(), mChannelEdges.end() );
+
+        if ( isReset )
+        {
+            // the falling edge starting the reset is shared with the next segment
+            const U64 fallingEdgeSample = mSegmentEdges.back();
+            mSegmentOffsets.push_back( mSegmentEdges.size() );
+            mSegmentEdges.push_back( fallingEdgeSample );
+        }
+
+        // decode once there is enough work for every thread, or when the
+        // capture so far is used up, so results aren't held back
+        if ( ( mSegmentEdges.size() >= batchEdgeCount ) || isCaughtUp )
         {
-            result.mBitValue = BIT_HIGH;
+            DecodeSegmentBatch();
         }
-        else
+
+        if ( ( mSegmentEdges.size() >= batchEdgeCount ) || isCaughtUp )
+        {
+            // only the segment being read is left, and it has no reset yet.
+            // Its LEDs are decoded as they are read, the same as by a single
+            // thread, so a capture ending part way through a packet shows them.
+            mSegmentStream.Start( mSegmentPool.FirstDecoder(), mSegmentEdges[0], this );
+            mSegmentStream.Push( mSegmentEdges.data() + 1, mSegmentEdges.size() - 1 );
+            mSegmentEdges.clear();
+        }
+
+        if ( isCaughtUp )
         {
-#if defined(LED_LOGGING)
-            std::cerr << "positive pulse timing doesn't match detected speed mode" << std::endl;
-            std::cerr << "\tdetected: " << (mDidDetectHighSpeed ? "Hi-speed" : "Normal") << std::endl;
-            std::cerr << "\t" << highTimeSec << std::endl;
-#endif
-            mChannelData->AdvanceToAbsPosition( fallingEdgeSample );
-            return result; // invalid result, reset required
+            CommitCaughtUpResults();
         }
     }
+}
 
-    // check for a too-short low timing
-    if ( mChannelData->WouldAdvancingCauseTransition( mMinimumLowDurationSec * mSampleRateHz ) )
-    {   
-        mChannelData->AdvanceToNextEdge();
-#if defined(LED_LOGGING)
-        const double lowTimeSec = ( mChannelData->GetSampleNumber() - fallingEdgeSample ) / mSampleRateHz;
-        std::cerr << "too short low pulse, invalid bit" << std::endl;
-        std::cerr << "\t" << lowTimeSec << std::endl;
-#endif
-        return result; // invalid result, reset required
+void AsyncRgbLedAnalyzer::DecodeSegmentBatch()
+{
+    // the last offset is the start of the segment still being read
+    const size_t segmentCount = mSegmentOffsets.size() - 1;
+
+    if ( segmentCount == 0 )
+    {
+        return;
     }
 
-    // check for a low period exceeding the minimum reset time
-    // if we exceed that, this is a reset
-    const int minResetSamples = static_cast<int>( mSettings->ResetTiming().mMinimumSec * mSampleRateHz );
+    if ( mDecodedSegments.size() < segmentCount )
+    {
+        mDecodedSegments.resize( segmentCount );
+    }
 
-    if ( !mChannelData->WouldAdvancingCauseTransition( minResetSamples ) )
+    mSegmentPool.DecodeBatch( mSegmentEdges.data(), mSegmentOffsets.data(), segmentCount, mTiming.mResetSamples,
+                              mDecodedSegments.data() );
+
+    // add the frames in sample order, numbering packets as they go
+    for ( size_t segment = 0; segment < segmentCount; ++segment )
     {
-        // if we see a single bit in between resets, we can't decode the speed,
-        // but this is meaningless anyway, so return an error
-        if ( mFirstBitAfterReset )
+        const DecodedSegment& decoded = mDecodedSegments[segment];
+
+        for ( const DecodedPacket& packet : decoded.mPackets )
         {
-#if defined(LED_LOGGING)
-            std::cerr << "No complete bit between resets, can't decode" << std::endl;
-#endif
-            return result; // return invalid
+            StartPacket();
+
+            for ( size_t led = packet.mFirstLed; led < packet.mFirstLed + packet.mLedCount; ++led )
+            {
+                const DecodedLed& decodedLed = decoded.mLeds[led];
+                AddLed( decodedLed.mRGB, decodedLed.mBeginSample, decodedLed.mEndSample, packet.mIsHighSpeed );
+            }
+
+            EndPacket( packet.mIsError, packet.mEndSample );
         }
+    }
 
-        mChannelData->Advance( minResetSamples );
-        result.mIsReset = true;
+    // keep the edges of the segment being read
+    const size_t decodedEdgeCount = mSegmentOffsets.back();
+    mSegmentEdges.erase( mSegmentEdges.begin(), mSegmentEdges.begin() + decodedEdgeCount );
+    mSegmentOffsets.assign( 1, 0 );
+}
+
+void AsyncRgbLedAnalyzer::StartPacket()
+{
+    mResults->CommitPacketAndStartNewPacket();
+    ++mPacketSequence;
+    mCurrentPacket.mFrameCount = 0;
+    mPacketLedCount = 0;
+    mIsPacketOpen = true;
+}
+
+void AsyncRgbLedAnalyzer::AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed )
+{
+    mDidDetectHighSpeed = isHighSpeed;
+    const U32 ledIndex = mPacketLedCount++;
+
+    if ( mIsPacketMode )
+    {
+        if ( mPacketColors.empty() )
+        {
+            mPacketBeginSample = beginSample;
+        }
+
+        mPacketColors.push_back( rgb );
+        mPacketEndSample = endSample;
     }
     else
     {
-        // we saw a transition, let's see the timing
-        mChannelData->AdvanceToNextEdge();
+        AddRunLed( rgb.ConvertToU64(), beginSample, endSample, ledIndex );
+    }
+}
+
+void AsyncRgbLedAnalyzer::EndPacket( bool isError, U64 packetEndSample )
+{
+    mIsPacketOpen = false;
+
+    // the frame ending the packet records if it ended badly
+    const U8 packetEndFlags = isError ? static_cast<U8>( FRAME_FLAG_PACKET_ERROR | DISPLAY_AS_WARNING_FLAG ) : 0;
+
+    if ( !mPacketColors.empty() )
+    {
+        AddPacketFrame( packetEndFlags );
+    }
+
+    if ( mRun.mIsActive )
+    {
+        FlushRun( packetEndFlags );
+    }
 
-        // the -1 is so the end of this frame, and start of the next, don't
-        // overlap.
-        result.mEndSample = mChannelData->GetSampleNumber() - 1;
+    if ( mCurrentPacket.mFrameCount > 0 )
+    {
+        mCurrentPacket.mLedCount = mPacketLedCount;
+        mPacketIndex.Add( mCurrentPacket );
     }
 
-    if ( result.mIsReset )
+    if ( mCommitPolicy.EndPacket( packetEndSample ) )
     {
-        // if this bit is also a reset, we can't check the low time since it
-        // will exceed the maximums, but we still want to accept that case
-        // as valid
-        result.mValid = true;
+        CommitPendingResults( packetEndSample );
+    }
+}
 
-        // use the nominal negative pulse timing for the frame ending.
-        double nominalNegativeSec = mSettings->DataTiming( result.mBitValue, mDidDetectHighSpeed ).mNegativeTiming.mNominalSec;
-        result.mEndSample = fallingEdgeSample + ( nominalNegativeSec * mSampleRateHz );
+void AsyncRgbLedAnalyzer::AddResultFrame( U8 flags, U64 beginSample, U64 endSample, U64 data1,
+        U32 ledIndex, U32 lastLedIndex )
+{
+    Frame frame;
+    frame.mFlags = flags | ( mDidDetectHighSpeed ? FRAME_FLAG_HIGH_SPEED : 0 );
+    frame.mStartingSampleInclusive = beginSample;
+    frame.mEndingSampleInclusive = endSample;
+    frame.mData1 = data1;
+    // the sequence was advanced when the current packet started
+    frame.mData2 = PackFrameData2( mPacketSequence - 1, ledIndex, lastLedIndex );
+    frame.mType = PackFrameType( mPacketSequence - 1 );
+    const U64 frameIndex = mResults->AddFrame( frame );
+
+    if ( mCurrentPacket.mFrameCount++ == 0 )
+    {
+        mCurrentPacket.mStartSample = beginSample;
+        mCurrentPacket.mFirstFrame = frameIndex;
     }
-    else if ( mFirstBitAfterReset )
+
+    mCurrentPacket.mEndSample = endSample;
+
+    if ( mCommitPolicy.AddFrame( endSample ) )
     {
-        const double lowTimeSec = ( result.mEndSample - fallingEdgeSample ) / mSampleRateHz;
-        // two-way classification. This is necessary because the the 0-data
-        // positive pulse of low-speed mode can match the 1-data positive pulse
-        // in high speed mode, for some controllers. Hence we need to correlate
-        // the high and low times to detect the speed mode
+        CommitPendingResults( endSample );
+    }
+}
+
+void AsyncRgbLedAnalyzer::AddPacketFrame( U8 flags )
+{
+    const U32 ledCount = static_cast<U32>( mPacketColors.size() );
+    const U64 arenaIndex = mColorArena.AddPacket( mPacketColors.data(), ledCount );
+    AddResultFrame( FRAME_FLAG_PACKET | flags, mPacketBeginSample, mPacketEndSample, arenaIndex, ledCount );
+    mPacketColors.clear();
+}
 
-        // this also sets mBitValue correct as a side-effect of the detection
-        result.mValid = DetectSpeedMode( highTimeSec, lowTimeSec, result.mBitValue );
+void AsyncRgbLedAnalyzer::AddRunLed( U64 rgb, U64 beginSample, U64 endSample, U32 ledIndex )
+{
+    if ( mIsRunLengthMode && mRun.mIsActive && ( mRun.mRGB == rgb ) && ( mRun.mLastLed + 1 == ledIndex ) )
+    {
+        mRun.mLastLed = ledIndex;
+        mRun.mEndSample = endSample;
+        return;
+    }
+
+    if ( mRun.mIsActive )
+    {
+        FlushRun( 0 );
+    }
+
+    mRun.mIsActive = true;
+    mRun.mRGB = rgb;
+    mRun.mFirstLed = ledIndex;
+    mRun.mLastLed = ledIndex;
+    mRun.mBeginSample = beginSample;
+    mRun.mEndSample = endSample;
+}
+
+void AsyncRgbLedAnalyzer::FlushRun( U8 flags )
+{
+    // a single LED is stored exactly as it would be without run-length mode
+    if ( mRun.mFirstLed == mRun.mLastLed )
+    {
+        AddResultFrame( flags, mRun.mBeginSample, mRun.mEndSample, mRun.mRGB, mRun.mFirstLed );
     }
     else
     {
-        // already detected the speed mode, ensure consistency
-        const double lowTimeSec = ( result.mEndSample - fallingEdgeSample ) / mSampleRateHz;
-    //    std::cout << "low time:" << lowTimeSec << " (" << (result.mEndSample - fallingEdgeSample  ) << ")" << std::endl;
+        AddResultFrame( FRAME_FLAG_RUN | flags, mRun.mBeginSample, mRun.mEndSample, mRun.mRGB,
+                        mRun.mFirstLed, mRun.mLastLed );
+    }
 
-        if ( mSettings->DataTiming( result.mBitValue, mDidDetectHighSpeed ).mNegativeTiming.WithinTolerance( lowTimeSec, mHalfSampleWidth ) )
-        {
-            // we are good
-            result.mValid = true;
-        }
-        else
-        {
-#if defined(LED_LOGGING)
-            // we could do further classification here on the error, eg speed mismatch,
-            // or bit value mismatch
-            std::cerr << "negative pulse timing doesn't match positive pulse" << std::endl;
-            std::cerr << "\tdetected: " << (mDidDetectHighSpeed ? "Hi-speed" : "Normal") << std::endl;
-            std::cerr << "\t" << highTimeSec <<  " / " << lowTimeSec << std::endl;
-            std::cerr << "\texpected:" << mSettings->DataTiming( result.mBitValue, mDidDetectHighSpeed ) << std::endl;
-#endif
-            result.mValid = false;
-        }
+    mRun.mIsActive = false;
+}
+
+void AsyncRgbLedAnalyzer::CommitPendingResults( U64 sample )
+{
+    mResults->CommitResults();
+    ReportProgress( sample );
+    mCommitPolicy.Committed( sample );
+}
+
+void AsyncRgbLedAnalyzer::CommitLiveResults()
+{
+    if ( !mCommitPolicy.IsIntervalElapsed( mChannelSample ) )
+    {
+        return;
+    }
+
+    // a run still growing is added as it stands, so the LEDs of a long
+    // packet show up while it is being sent
+    if ( mRun.mIsActive )
+    {
+        FlushRun( 0 );
     }
 
-    return result;
+    if ( mCommitPolicy.IsIntervalElapsed( mChannelSample ) )
+    {
+        CommitPendingResults( mChannelSample );
+    }
 }
 
-bool AsyncRgbLedAnalyzer::DetectSpeedMode( double positiveTimeSec, double negativeTimeSec, BitState& value )
+bool AsyncRgbLedAnalyzer::IsCaughtUp()
 {
-    const double halfSampleWidth = 0.5 / mSampleRateHz;
-    mDidDetectHighSpeed = false;
+    return !mIsReplayingCache && !mChannelData->DoMoreTransitionsExistInCurrentData();
+}
 
-    // low speed bits
-    for ( const auto b : {BIT_LOW, BIT_HIGH} )
+void AsyncRgbLedAnalyzer::CommitCaughtUpResults()
+{
+    // the rest of the packet being decoded may never arrive, such as at the
+    // end of a fixed-length capture, so a held back LED or run is added now
+    if ( mRun.mIsActive )
     {
-        if ( mSettings->DataTiming( b ).WithinTolerance( positiveTimeSec, negativeTimeSec, halfSampleWidth ) )
-        {
-            value = b;
-            mFirstBitAfterReset = false;
-            return true;
-        }
+        FlushRun( 0 );
     }
 
-    if ( mSettings->IsHighSpeedSupported() )
+    if ( mCommitPolicy.PendingFrames() > 0 )
     {
-        // high speed bits
-        for ( const auto b : {BIT_LOW, BIT_HIGH} )
-        {
-            if ( mSettings->DataTiming( b, true ).WithinTolerance( positiveTimeSec, negativeTimeSec, halfSampleWidth ) )
-            {
-                mDidDetectHighSpeed = true;
-                value = b;
-                mFirstBitAfterReset = false;
-                return true;
-            }
-        }
-    } // of high-speed mode tests
+        CommitPendingResults( mChannelSample );
+    }
+}
 
-    std::cerr << "failed to classify: " << positiveTimeSec << "/" << negativeTimeSec << std::endl;
-    return false;
+void AsyncRgbLedAnalyzer::SkipToNewestSample( LedDecoder& decoder )
+{
+    // the packet being decoded is cut short, and decoding starts again at
+    // the first reset after the newest sample. After an error the decoder
+    // is already waiting for a reset, with no packet open.
+    if ( mIsPacketOpen )
+    {
+        EndPacket( true, mChannelSample );
+    }
+
+    mForcedSkipSample = std::numeric_limits<U64>::max();
+
+    const U64 newestSample = mLiveLag.NewestSample( LiveClockSeconds() );
+
+    if ( newestSample > mChannelSample )
+    {
+        mChannelData->AdvanceToAbsPosition( newestSample );
+    }
+
+    if ( mChannelData->GetBitState() == BIT_HIGH )
+    {
+        mChannelData->AdvanceToNextEdge();
+    }
+
+    mChannelSample = mChannelData->GetSampleNumber();
+    mChannelLevel = BIT_LOW;
+    mChannelInReset = false;
+
+    // the cache only holds edges up to the first one skipped
+    mIsCachingEdges = false;
+
+    decoder.Start( mChannelSample, this );
+    mLiveLag.CaughtUp( mChannelSample, LiveClockSeconds() );
+    CommitPendingResults( mChannelSample );
 }
 
 bool AsyncRgbLedAnalyzer::NeedsRerun()
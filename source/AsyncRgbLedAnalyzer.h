@@ -3,14 +3,22 @@
 
 #include <Analyzer.h>
 
+#include <limits>
+
 #include "AsyncRgbLedSimulationDataGenerator.h"
 #include "AsyncRgbLedHelpers.h"
+#include "AsyncRgbLedColorArena.h"
+#include "AsyncRgbLedPacketIndex.h"
+#include "AsyncRgbLedLazyDecode.h"
+#include "AsyncRgbLedDecoder.h"
+#include "AsyncRgbLedEdgeCache.h"
+#include "AsyncRgbLedSegmentDecoder.h"
 
 // forward decls
 class AsyncRgbLedAnalyzerSettings;
 class AsyncRgbLedAnalyzerResults;
 
-class ANALYZER_EXPORT AsyncRgbLedAnalyzer : public Analyzer2
+class ANALYZER_EXPORT AsyncRgbLedAnalyzer : public Analyzer2, private DecoderOutput
 {
     public:
         AsyncRgbLedAnalyzer();
@@ -25,6 +33,31 @@ class ANALYZER_EXPORT AsyncRgbLedAnalyzer : public Analyzer2
         const char* GetAnalyzerName() const override;
         bool NeedsRerun() override;
 
+        /// LED colors of packet frames, when storing results per packet
+        const LedColorArena& ColorArena() const
+        {
+            return mColorArena;
+        }
+
+        /// pulses of timeline packet frames, decoded when they are read
+        const LazyPacketStore& LazyPackets() const
+        {
+            return mLazyPackets;
+        }
+
+        /// every packet decoded so far, for finding the packet at a sample
+        const PacketIndex& GetPacketIndex() const
+        {
+            return mPacketIndex;
+        }
+
+        /// live mode: skip ahead once decoding reaches sample, as if it had
+        /// fallen behind there. Lets tests choose where a skip happens.
+        void ForceLiveSkip( U64 sample )
+        {
+            mForcedSkipSample = sample;
+        }
+
     protected: //vars
         std::unique_ptr< AsyncRgbLedAnalyzerSettings > mSettings;
         std::unique_ptr< AsyncRgbLedAnalyzerResults > mResults;
@@ -35,40 +68,140 @@ class ANALYZER_EXPORT AsyncRgbLedAnalyzer : public Analyzer2
 
         // analysis vars:
         double mSampleRateHz = 0.0;
-        double mHalfSampleWidth = 0.0;
 
-        // minimum valid low time for a data bit, in either speed mode supported
-        // by the controller.
-        double mMinimumLowDurationSec = 0.0;
+        // controller timing in samples, computed at the start of analysis
+        DecoderTiming mTiming;
 
-        bool mFirstBitAfterReset = false;
-        bool mDidDetectHighSpeed = false;
-    private:
+        CommitPolicy mCommitPolicy;
 
-        struct RGBResult
-        {
-            bool mValid = false;
-            bool mIsReset = false;
-            RGBValue mRGB;
-            U64 mValueBeginSample = 0;
-            U64 mValueEndSample = 0;
-        };
+        // number of packets started, stored in every frame
+        U64 mPacketSequence = 0;
+
+        // LEDs decoded in the current packet, between StartPacket and EndPacket
+        U32 mPacketLedCount = 0;
+        bool mIsPacketOpen = false;
+
+        // packets with at least one frame, and the one being decoded
+        PacketIndex mPacketIndex;
+        PacketIndexEntry mCurrentPacket = {};
 
-        RGBResult ReadRGBTriple();
+        // packet mode: colors of the packet being decoded, added to the
+        // arena as a whole when the packet ends
+        bool mIsPacketMode = false;
+        LedColorArena mColorArena;
+        std::vector<RGBValue> mPacketColors;
+        U64 mPacketBeginSample = 0;
+        U64 mPacketEndSample = 0;
 
-        struct ReadResult
+        // run-length mode: consecutive identical LEDs waiting to be added
+        // as a single frame. Otherwise each run is a single LED, held back
+        // so the end of its packet can flag it.
+        struct LedRun
         {
-            bool mValid = false;
-            bool mIsReset = false;
-            BitState mBitValue = BIT_LOW;
+            bool mIsActive = false;
+            U64 mRGB = 0;
+            U32 mFirstLed = 0;
+            U32 mLastLed = 0;
             U64 mBeginSample = 0;
             U64 mEndSample = 0;
         };
 
-        ReadResult ReadBit();
-        void SynchronizeToReset();
+        bool mIsRunLengthMode = false;
+        LedRun mRun;
+
+        // timeline mode: packets are found by their resets, and their pulses
+        // stored to be decoded later. The pulses of each block of edges read
+        // are collected, then added to the store at once.
+        bool mIsTimelineMode = false;
+        LazyPacketStore mLazyPackets;
+        std::vector<U32> mPacketPulses;
+
+        // parallel decoding: the edges of a batch of segments, each running
+        // from one reset to the next, the threads decoding them, and the
+        // LEDs decoded from each segment. A segment longer than a batch is
+        // streamed through the first decoder instead.
+        std::vector<U64> mSegmentEdges;
+        std::vector<size_t> mSegmentOffsets;
+        SegmentDecodePool mSegmentPool;
+        std::vector<DecodedSegment> mDecodedSegments;
+        SegmentStream mSegmentStream;
+
+        bool mDidDetectHighSpeed = false;
+
+        // the latest edges read from mChannelData, and the line state and
+        // read position after them
+        std::vector<U64> mChannelEdges;
+        BitState mChannelLevel = BIT_LOW;
+        bool mChannelInReset = false;
+        U64 mChannelSample = 0;
+
+        // every edge read so far, and the capture it was read from. When
+        // analysis runs again, such as after a settings change, the cached
+        // edges are decoded without reading every edge of mChannelData.
+        EdgeCache mEdgeCache;
+        EdgeCache::Reader mCacheReader;
+        Channel mEdgeCacheChannel;
+        double mEdgeCacheSampleRateHz = 0.0;
+        U64 mEdgeCacheTriggerSample = 0;
+        bool mIsReplayingCache = false;
+        bool mIsCachingEdges = true;
+
+        // live mode: results are committed within mLiveLatencySamples of
+        // signal time, and decoding skips ahead if it falls behind
+        bool mIsLive = false;
+        U64 mLiveLatencySamples = 0;
+        LiveLagTracker mLiveLag;
+        U64 mForcedSkipSample = std::numeric_limits<U64>::max();
+    private:
 
-        bool DetectSpeedMode( double positiveTimeSec, double negativeTimeSec, BitState& value );
+        // replay mEdgeCache if it holds the start of this capture, or
+        // clear it to cache this analysis
+        void StartEdgeCache();
+
+        // read the next edges into mChannelEdges, stopping early at a reset
+        // or the end of the capture so far. Returns true at a reset, with
+        // the read position at the falling edge starting it.
+        bool ReadChannelEdges();
+        bool ReadCachedEdges();
+
+        // the channel data agrees with the cache at the last edge replayed:
+        // the same level, and the same next edge. Moves the read position
+        // of mChannelData up to that edge.
+        bool IsCacheInChannel();
+        void DropEdgeCache();
+
+        // feed the channel edges to a single LedDecoder
+        void DecodeChannel();
+
+        void ScanTimeline();
+
+        // split the capture at resets, and decode batches of segments on
+        // several threads
+        void DecodeSegmentsInParallel();
+        void DecodeSegmentBatch();
+
+        void CommitPendingResults( U64 sample );
+
+        // the capture so far is used up, and everything decoded from it is
+        // committed so it isn't held back until more arrives
+        bool IsCaughtUp();
+        void CommitCaughtUpResults();
+
+        // live mode: commit whatever is decoded once the latency is used up,
+        // and skip to the newest sample of the capture when behind it
+        void CommitLiveResults();
+        void SkipToNewestSample( LedDecoder& decoder );
+
+        // DecoderOutput: store decoded LEDs according to the results mode
+        void StartPacket() override;
+        void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed ) override;
+        void EndPacket( bool isError, U64 packetEndSample ) override;
+
+        void AddResultFrame( U8 flags, U64 beginSample, U64 endSample, U64 data1,
+                             U32 ledIndex, U32 lastLedIndex = 0 );
+        void AddPacketFrame( U8 flags );
+        void AddRunLed( U64 rgb, U64 beginSample, U64 endSample, U32 ledIndex );
+        void FlushRun( U8 flags );
 };
 
 extern "C" {
@@ -2,8 +2,48 @@
 #include <AnalyzerHelpers.h>
 #include "AsyncRgbLedAnalyzer.h"
 #include "AsyncRgbLedAnalyzerSettings.h"
+#include "AsyncRgbLedExport.h"
+#include <algorithm> // for std::min/max()
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    // rows formatted by one export thread at a time; progress and
+    // cancellation are checked as each chunk is written
+    const U64 EXPORT_CHUNK_ROWS = 32768;
+
+    // LED colors unpacked from the color arena at a time
+    const U32 ARENA_READ_BLOCK = 256;
+
+    // colors listed in the bubble and tabular text of a packet frame
+    const U32 PACKET_TEXT_COLORS = 8;
+
+    /// number of LEDs a frame covers
+    U64 FrameLedCount( const Frame& frame )
+    {
+        if ( frame.mFlags & FRAME_FLAG_PACKET )
+        {
+            return FrameLedIndex( frame.mData2 );
+        }
+
+        if ( frame.mFlags & FRAME_FLAG_RUN )
+        {
+            return static_cast<U64>( FrameLastLedIndex( frame.mData2 ) ) - FrameLedIndex( frame.mData2 ) + 1;
+        }
+
+        return 1;
+    }
+
+    /// first sample of one LED of a packet or run frame, assuming the LEDs are evenly spaced
+    U64 InterpolateLedSample( const Frame& frame, U64 ledIndex, U64 ledCount )
+    {
+        const U64 span = frame.mEndingSampleInclusive - frame.mStartingSampleInclusive + 1;
+        return frame.mStartingSampleInclusive + ( span * ledIndex ) / ledCount;
+    }
+}
 
 AsyncRgbLedAnalyzerResults::AsyncRgbLedAnalyzerResults( AsyncRgbLedAnalyzer* analyzer, AsyncRgbLedAnalyzerSettings* settings )
     :   AnalyzerResults(),
@@ -14,6 +54,10 @@ AsyncRgbLedAnalyzerResults::AsyncRgbLedAnalyzerResults( AsyncRgbLedAnalyzer* ana
 
 AsyncRgbLedAnalyzerResults::~AsyncRgbLedAnalyzerResults()
 {
+#if defined(LED_LOGGING)
+    std::cerr << "text cache hits:" << mTextCache.Hits() << " misses:" << mTextCache.Misses()
+              << " hit rate:" << mTextCache.HitRate() << std::endl;
+#endif
 }
 
 void AsyncRgbLedAnalyzerResults::GenerateRGBStrings( const RGBValue& rgb, DisplayBase base, size_t bufSize, char* redBuf, char* greenBuff, char* blueBuf )
@@ -28,16 +72,39 @@ void AsyncRgbLedAnalyzerResults::GenerateRGBStrings( const RGBValue& rgb, Displa
 void AsyncRgbLedAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
 {
     ClearResultStrings();
-    Frame frame = GetFrame( frame_index );
 
-    U32 ledIndex = frame.mData2;
+    ResultTextCache::Strings strings = mTextCache.Find( frame_index, display_base, ResultTextCache::BUBBLE_TEXT );
+
+    if ( !strings )
+    {
+        std::vector<std::string> built;
+        BuildBubbleText( GetFrame( frame_index ), display_base, built );
+        strings = mTextCache.Insert( frame_index, display_base, ResultTextCache::BUBBLE_TEXT, std::move( built ) );
+    }
+
+    for ( const std::string& text : *strings )
+    {
+        AddResultString( text.c_str() );
+    }
+}
+
+void AsyncRgbLedAnalyzerResults::BuildBubbleText( const Frame& frame, DisplayBase display_base, std::vector<std::string>& strings )
+{
+    if ( frame.mFlags & FRAME_FLAG_PACKET )
+    {
+        BuildPacketBubbleText( frame, strings );
+        return;
+    }
+
+    char ledIndex[32];
+    FormatLedIndex( frame, ledIndex, sizeof( ledIndex ) );
     RGBValue rgb = RGBValue::CreateFromU64( frame.mData1 );
 
     // generate a Web/CSS representation of the color value
     U8 webColor[3];
     rgb.ConvertTo8Bit( mSettings->BitSize(), webColor );
     char webBuf[8];
-    ::snprintf( webBuf, sizeof( webBuf ), "#%02x%02x%02x", webColor[0], webColor[1], webColor[2] );
+    FormatWebColor( webColor, webBuf );
 
     const int colorNumericBufferLength = 16;
     char redString[colorNumericBufferLength],
@@ -51,81 +118,523 @@ void AsyncRgbLedAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& c
     char buf[256];
 
     // example: LED: 13 Red: 0x1A Green: 0x2B Blue: 0x3C #1A2B3C
-    ::snprintf( buf, sizeof( buf ), "LED %d Red: %s Green: %s Blue: %s %s", ledIndex, redString, greenString, blueString, webBuf );
-    AddResultString( buf );
+    // or, for a run of LEDs: LED 10-309 Red: 0x1A Green: 0x2B Blue: 0x3C #1A2B3C
+    ::snprintf( buf, sizeof( buf ), "LED %s Red: %s Green: %s Blue: %s %s", ledIndex, redString, greenString, blueString, webBuf );
+    strings.push_back( buf );
 
     // example: 13 R:0x1A G:0x2B B:0x3C #1A2B3C
-    ::snprintf( buf, sizeof( buf ), "%d R: %s G: %s B: %s %s", ledIndex, redString, greenString, blueString, webBuf );
-    AddResultString( buf );
+    ::snprintf( buf, sizeof( buf ), "%s R: %s G: %s B: %s %s", ledIndex, redString, greenString, blueString, webBuf );
+    strings.push_back( buf );
 
     // example: (13) #1A2B3C
-    ::snprintf( buf, sizeof( buf ), "(%d) %s", ledIndex, webBuf );
-    AddResultString( buf );
+    ::snprintf( buf, sizeof( buf ), "(%s) %s", ledIndex, webBuf );
+    strings.push_back( buf );
 
     // example: #1A2B3C
-    AddResultString( webBuf );
+    strings.push_back( webBuf );
+}
+
+void AsyncRgbLedAnalyzerResults::FormatLedIndex( const Frame& frame, char* buf, size_t bufSize )
+{
+    if ( frame.mFlags & FRAME_FLAG_RUN )
+    {
+        ::snprintf( buf, bufSize, "%u-%u", FrameLedIndex( frame.mData2 ), FrameLastLedIndex( frame.mData2 ) );
+    }
+    else
+    {
+        ::snprintf( buf, bufSize, "%u", FrameLedIndex( frame.mData2 ) );
+    }
+}
+
+void AsyncRgbLedAnalyzerResults::BuildPacketBubbleText( const Frame& frame, std::vector<std::string>& strings )
+{
+    const U32 ledCount = FrameLedIndex( frame.mData2 );
+    const std::string colors = PacketColorList( frame, PACKET_TEXT_COLORS );
+    const std::string firstColor = PacketColorList( frame, 1 );
+    char buf[256];
+
+    // example: Packet 300 LEDs: #1a2b3c #4d5e6f ...
+    ::snprintf( buf, sizeof( buf ), "Packet %u LEDs: %s", ledCount, colors.c_str() );
+    strings.push_back( buf );
+
+    // example: 300 LEDs: #1a2b3c ...
+    ::snprintf( buf, sizeof( buf ), "%u LEDs: %s", ledCount, firstColor.c_str() );
+    strings.push_back( buf );
+
+    // example: 300 LEDs
+    ::snprintf( buf, sizeof( buf ), "%u LEDs", ledCount );
+    strings.push_back( buf );
+
+    // example: (300)
+    ::snprintf( buf, sizeof( buf ), "(%u)", ledCount );
+    strings.push_back( buf );
+}
+
+std::string AsyncRgbLedAnalyzerResults::PacketColorList( const Frame& frame, U32 maxColors )
+{
+    const U32 ledCount = FrameLedIndex( frame.mData2 );
+    RGBValue colors[PACKET_TEXT_COLORS];
+    const U32 count = GetPacketColors( frame, 0, std::min( maxColors, PACKET_TEXT_COLORS ), colors );
+
+    std::string result;
+
+    for ( U32 i = 0; i < count; ++i )
+    {
+        U8 webColor[3];
+        colors[i].ConvertTo8Bit( mSettings->BitSize(), webColor );
+        char webBuf[8];
+        FormatWebColor( webColor, webBuf );
+
+        if ( i > 0 )
+        {
+            result += ' ';
+        }
+
+        result += webBuf;
+    }
+
+    if ( count < ledCount )
+    {
+        result += " ...";
+    }
+
+    return result;
+}
+
+U32 AsyncRgbLedAnalyzerResults::GetPacketColors( const Frame& frame, U32 firstLed, U32 count, RGBValue* colors )
+{
+    if ( frame.mFlags & FRAME_FLAG_LAZY )
+    {
+        return mAnalyzer->LazyPackets().GetColors( frame.mData1, firstLed, count, colors );
+    }
+
+    return mAnalyzer->ColorArena().GetColors( frame.mData1, firstLed, count, colors );
+}
+
+AsyncRgbLedAnalyzerResults::PacketColorReader::PacketColorReader( const AsyncRgbLedAnalyzer& analyzer ) :
+    mArena( analyzer.ColorArena() ),
+    mLazy( analyzer.LazyPackets() )
+{
+}
+
+U32 AsyncRgbLedAnalyzerResults::GetPacketColors( const Frame& frame, PacketColorReader& reader, U32 firstLed, U32 count,
+        RGBValue* colors )
+{
+    if ( frame.mFlags & FRAME_FLAG_LAZY )
+    {
+        return reader.mLazy.GetColors( frame.mData1, firstLed, count, colors );
+    }
+
+    return reader.mArena.GetColors( frame.mData1, firstLed, count, colors );
+}
+
+template <typename LedFunction>
+void AsyncRgbLedAnalyzerResults::ForEachLed( const Frame& frame, PacketColorReader& reader, LedFunction ledFunction )
+{
+    if ( frame.mFlags & FRAME_FLAG_RUN )
+    {
+        const RGBValue rgb = RGBValue::CreateFromU64( frame.mData1 );
+        const U32 firstLed = FrameLedIndex( frame.mData2 );
+        const U64 ledCount = FrameLedCount( frame );
+
+        for ( U64 i = 0; i < ledCount; ++i )
+        {
+            ledFunction( InterpolateLedSample( frame, i, ledCount ),
+                         InterpolateLedSample( frame, i + 1, ledCount ) - 1,
+                         firstLed + i, rgb );
+        }
+
+        return;
+    }
+
+    if ( !( frame.mFlags & FRAME_FLAG_PACKET ) )
+    {
+        ledFunction( frame.mStartingSampleInclusive, frame.mEndingSampleInclusive,
+                     FrameLedIndex( frame.mData2 ), RGBValue::CreateFromU64( frame.mData1 ) );
+        return;
+    }
+
+    // expand a packet frame, a block at a time
+    const U32 ledCount = FrameLedIndex( frame.mData2 );
+    RGBValue colors[ARENA_READ_BLOCK];
+
+    for ( U32 firstLed = 0; firstLed < ledCount; )
+    {
+        const U32 count = GetPacketColors( frame, reader, firstLed, std::min( ARENA_READ_BLOCK, ledCount - firstLed ), colors );
+
+        if ( count == 0 )
+        {
+            break;
+        }
+
+        for ( U32 i = 0; i < count; ++i )
+        {
+            const U64 led = firstLed + i;
+            ledFunction( InterpolateLedSample( frame, led, ledCount ),
+                         InterpolateLedSample( frame, led + 1, ledCount ) - 1,
+                         led, colors[i] );
+        }
+
+        firstLed += count;
+    }
+}
+
+AsyncRgbLedAnalyzerResults::ExportFilter AsyncRgbLedAnalyzerResults::CreateExportFilter()
+{
+    ExportFilter filter;
+    filter.mEndFrame = GetNumFrames();
+    filter.mFirstLed = mSettings->mExportFirstLed;
+    filter.mLastLed = mSettings->mExportLastLed;
+
+    // frames of a packet which is still being decoded aren't indexed yet,
+    // but they follow the frames of every indexed packet
+    const PacketIndex& index = mAnalyzer->GetPacketIndex();
+    PacketIndexEntry entry;
+
+    if ( mSettings->mHasExportStart )
+    {
+        filter.mStartSample = SampleAtTime( mSettings->mExportStartSec );
+        const U64 packet = index.FirstPacketEndingAfter( filter.mStartSample );
+
+        if ( index.Get( packet, entry ) )
+        {
+            filter.mFirstFrame = entry.mFirstFrame;
+        }
+        else if ( ( packet > 0 ) && index.Get( packet - 1, entry ) )
+        {
+            filter.mFirstFrame = entry.mFirstFrame + entry.mFrameCount;
+        }
+    }
+
+    if ( mSettings->mHasExportEnd )
+    {
+        filter.mEndSample = SampleAtTime( mSettings->mExportEndSec );
+        U64 packet = 0;
+
+        if ( index.FindPacketAtSample( filter.mEndSample, packet ) )
+        {
+            if ( index.Get( packet + 1, entry ) )
+            {
+                filter.mEndFrame = entry.mFirstFrame;
+            }
+        }
+        else if ( index.Get( 0, entry ) )
+        {
+            // the window ends before the first packet
+            filter.mEndFrame = entry.mFirstFrame;
+        }
+    }
+
+    filter.mEndFrame = std::max( filter.mEndFrame, filter.mFirstFrame );
+    return filter;
+}
+
+AsyncRgbLedAnalyzerResults::ExportPlan AsyncRgbLedAnalyzerResults::PlanExport( const ExportFilter& filter )
+{
+    ExportPlan plan;
+
+    if ( mSettings->mResultsMode == AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED )
+    {
+        // one row per frame, so chunks can be placed without reading frames
+        for ( U64 first = filter.mFirstFrame; first < filter.mEndFrame; first += EXPORT_CHUNK_ROWS )
+        {
+            plan.mChunkStarts.push_back( first );
+        }
+
+        plan.mChunkStarts.push_back( filter.mEndFrame );
+        return plan;
+    }
+
+    // packet and run frames expand to many rows; balance the chunks by row count
+    U64 chunkRows = 0;
+
+    for ( U64 i = filter.mFirstFrame; i < filter.mEndFrame; i++ )
+    {
+        const Frame frame = GetFrame( i );
+
+        if ( chunkRows == 0 )
+        {
+            plan.mChunkStarts.push_back( i );
+        }
+
+        chunkRows += FrameLedCount( frame );
+
+        if ( chunkRows >= EXPORT_CHUNK_ROWS )
+        {
+            chunkRows = 0;
+        }
+    }
+
+    plan.mChunkStarts.push_back( filter.mEndFrame );
+    return plan;
 }
 
 void AsyncRgbLedAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
 {
+    if ( export_type_user_id == AsyncRgbLedAnalyzerSettings::EXPORT_BINARY )
+    {
+        GenerateBinaryExportFile( file );
+        return;
+    }
+
+    // text mode, so rows end in the platform's line ending as std::endl did
     std::ofstream file_stream( file, std::ios::out );
+    file_stream << "Time [s], Packet ID, LED Index, Red, Green, Blue, Web-CSS\n";
+
+    const ExportFilter filter = CreateExportFilter();
+    const U64 frameCount = filter.mEndFrame - filter.mFirstFrame;
+    const ExportPlan plan = PlanExport( filter );
+    const U64 chunkCount = plan.mChunkStarts.size() - 1;
+    const U64 threadCount = std::max<U64>( 1, std::thread::hardware_concurrency() );
+
+    // frames are read-only once analysis is done, so chunks are formatted
+    // concurrently, one wave of chunks at a time, and written out in order.
+    // The main thread formats one chunk of each wave itself, and handles all
+    // the file writes and progress updates.
+    std::vector<std::string> chunkText( static_cast<size_t>( std::min( threadCount, std::max<U64>( chunkCount, 1 ) ) ) );
+
+    for ( U64 firstChunk = 0; firstChunk < chunkCount; firstChunk += chunkText.size() )
+    {
+        const size_t waveChunks = static_cast<size_t>( std::min<U64>( chunkText.size(), chunkCount - firstChunk ) );
+        std::vector<std::thread> workers;
+
+        for ( size_t c = 1; c < waveChunks; ++c )
+        {
+            workers.emplace_back( [this, &chunkText, &plan, &filter, c, firstChunk, display_base]()
+            {
+                chunkText[c] = FormatExportChunk( plan.mChunkStarts[firstChunk + c],
+                                                  plan.mChunkStarts[firstChunk + c + 1], filter, display_base );
+            } );
+        }
 
-    U64 trigger_sample = mAnalyzer->GetTriggerSample();
-    U32 sample_rate = mAnalyzer->GetSampleRate();
+        chunkText[0] = FormatExportChunk( plan.mChunkStarts[firstChunk], plan.mChunkStarts[firstChunk + 1],
+                                          filter, display_base );
+
+        for ( auto& worker : workers )
+        {
+            worker.join();
+        }
+
+        for ( size_t c = 0; c < waveChunks; ++c )
+        {
+            file_stream.write( chunkText[c].data(), static_cast<std::streamsize>( chunkText[c].size() ) );
+            chunkText[c].clear();
 
-    file_stream << "Time [s], Packet ID, LED Index, Red, Green, Blue, Web-CSS" << std::endl;
+            if ( UpdateExportProgressAndCheckForCancel( plan.mChunkStarts[firstChunk + c + 1] - filter.mFirstFrame, frameCount ) )
+            {
+                return;
+            }
+        }
+    }
+}
 
-    const U64 num_frames = GetNumFrames();
+void AsyncRgbLedAnalyzerResults::GenerateBinaryExportFile( const char* file )
+{
+    std::ofstream file_stream( file, std::ios::out | std::ios::binary );
+    const ExportFilter filter = CreateExportFilter();
+    const U64 frameCount = filter.mEndFrame - filter.mFirstFrame;
+
+    BinaryExportHeader header = {};
+    std::copy( BINARY_EXPORT_MAGIC, BINARY_EXPORT_MAGIC + sizeof( header.mMagic ), header.mMagic );
+    header.mVersion = BINARY_EXPORT_VERSION;
+    header.mHeaderSize = sizeof( BinaryExportHeader );
+    header.mController = mSettings->mLEDController;
+    header.mBitSize = mSettings->BitSize();
+    header.mChannelCount = mSettings->LEDChannelCount();
+    header.mSampleRateHz = mAnalyzer->GetSampleRate();
+    header.mRecordSize = sizeof( BinaryExportRecord );
+    header.mTriggerSample = mAnalyzer->GetTriggerSample();
+    header.mRecordsOffset = sizeof( BinaryExportHeader );
+
+    // the record count and packet table are only known once the records
+    // are written, so the header is rewritten at the end
+    std::vector<BinaryExportPacket> packets;
+    U64 recordIndex = 0;
+
+    // packet and run frames expand to many rows, so progress is counted
+    // in rows, and a cancel can stop part way through a frame
+    U64 progressRows = 0;
+    bool isCancelled = false;
 
-    for ( U64 i = 0; i < num_frames; i++ )
     {
-        const Frame frame = GetFrame( i );
-        U64 packetId = GetPacketContainingFrameSequential( num_frames );
+        ExportBuffer out( file_stream );
+        out.AppendRaw( header );
+        PacketColorReader reader( *mAnalyzer );
+
+        for ( U64 i = filter.mFirstFrame; i < filter.mEndFrame; i++ )
+        {
+            const Frame frame = GetFrame( i );
+            const U32 recordPacketId = FramePacketSequence( frame.mData2, frame.mType );
+
+            ForEachLed( frame, reader, [&]( U64 beginSample, U64 endSample, U64 ledIndex, const RGBValue & rgb )
+            {
+                if ( isCancelled )
+                {
+                    return;
+                }
+
+                if ( ++progressRows == EXPORT_CHUNK_ROWS )
+                {
+                    progressRows = 0;
+                    isCancelled = UpdateExportProgressAndCheckForCancel( i - filter.mFirstFrame, frameCount );
+
+                    if ( isCancelled )
+                    {
+                        return;
+                    }
+                }
+
+                if ( !filter.Includes( beginSample, ledIndex ) )
+                {
+                    return;
+                }
+
+                BinaryExportRecord record = {};
+                record.mStartSample = beginSample;
+                record.mEndSample = endSample;
+                record.mPacketId = recordPacketId;
+                record.mLedIndex = static_cast<U32>( ledIndex );
+                record.mRed = rgb.red;
+                record.mGreen = rgb.green;
+                record.mBlue = rgb.blue;
+                out.AppendRaw( record );
+
+                if ( packets.empty() || ( packets.back().mPacketId != recordPacketId ) )
+                {
+                    packets.push_back( BinaryExportPacket{recordIndex, recordPacketId, 0} );
+                }
+
+                ++packets.back().mRecordCount;
+
+                ++recordIndex;
+            } );
+
+            if ( isCancelled )
+            {
+                return;
+            }
+        }
 
-        if ( packetId == INVALID_RESULT_INDEX )
+        for ( const auto& packet : packets )
         {
-            packetId = -1;
+            out.AppendRaw( packet );
         }
+    }
 
-        char time_str[128];
-        AnalyzerHelpers::GetTimeString( frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128 );
+    header.mRecordCount = recordIndex;
+    header.mPacketCount = packets.size();
+    header.mPacketTableOffset = header.mRecordsOffset + recordIndex * sizeof( BinaryExportRecord );
+    file_stream.seekp( 0 );
+    file_stream.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
 
-        RGBValue rgb = RGBValue::CreateFromU64( frame.mData1 );
+    UpdateExportProgressAndCheckForCancel( frameCount, frameCount );
+}
 
-        // RGB numerical value representation
-        const size_t bufSize = 16;
-        char rs[bufSize], gs[bufSize], bs[bufSize];
-        GenerateRGBStrings( rgb, display_base, bufSize, rs, gs, bs );
+std::string AsyncRgbLedAnalyzerResults::FormatExportChunk( U64 firstFrame, U64 endFrame, const ExportFilter& filter,
+        DisplayBase display_base )
+{
+    const U64 trigger_sample = mAnalyzer->GetTriggerSample();
+    const U32 sample_rate = mAnalyzer->GetSampleRate();
+    const U8 bitSize = mSettings->BitSize();
 
-        // CSS representation
-        U8 webColor[3];
-        rgb.ConvertTo8Bit( mSettings->BitSize(), webColor );
-        char webBuf[8];
-        ::snprintf( webBuf, sizeof( webBuf ), "#%02x%02x%02x", webColor[0], webColor[1], webColor[2] );
+    std::ostringstream chunkStream;
 
-        file_stream << time_str << "," << packetId << "," << frame.mData2 << ","
-                    << rs << ","
-                    << gs << ","
-                    << bs << ","
-                    << webBuf << std::endl;
+    {
+        ExportBuffer out( chunkStream );
+        PacketColorReader reader( *mAnalyzer );
 
-        if ( UpdateExportProgressAndCheckForCancel( i, num_frames ) == true )
+        for ( U64 i = firstFrame; i < endFrame; i++ )
         {
-            file_stream.close();
-            return;
+            const Frame frame = GetFrame( i );
+            const U32 packetId = FramePacketSequence( frame.mData2, frame.mType );
+
+            ForEachLed( frame, reader, [&]( U64 beginSample, U64, U64 ledIndex, const RGBValue & rgb )
+            {
+                if ( !filter.Includes( beginSample, ledIndex ) )
+                {
+                    return;
+                }
+
+                out.AppendTime( beginSample, trigger_sample, sample_rate );
+                out.Append( ',' );
+
+                out.AppendDecimal( packetId );
+
+                out.Append( ',' );
+                out.AppendDecimal( ledIndex );
+
+                for ( const U16 channel : {rgb.red, rgb.green, rgb.blue} )
+                {
+                    out.Append( ',' );
+                    AppendNumber( out, channel, display_base, bitSize );
+                }
+
+                // CSS representation
+                U8 webColor[3];
+                rgb.ConvertTo8Bit( bitSize, webColor );
+                out.Append( ',' );
+                out.AppendWebColor( webColor );
+                out.Append( '\n' );
+            } );
         }
     }
 
-    file_stream.close();
+    return chunkStream.str();
+}
+
+void AsyncRgbLedAnalyzerResults::AppendNumber( ExportBuffer& out, U16 value, DisplayBase base, U8 bitSize )
+{
+    switch ( base )
+    {
+        case Decimal:
+            out.AppendDecimal( value );
+            break;
+
+        case Hexadecimal:
+            out.AppendHex( value, bitSize );
+            break;
+
+        default:
+        {
+            char buf[32];
+            AnalyzerHelpers::GetNumberString( value, base, bitSize, buf, sizeof( buf ) );
+            out.Append( buf );
+            break;
+        }
+    }
 }
 
 void AsyncRgbLedAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
 {
 #ifdef SUPPORTS_PROTOCOL_SEARCH
-    Frame frame = GetFrame( frame_index );
     ClearTabularText();
 
-    const U32 ledIndex = frame.mData2;
+    ResultTextCache::Strings strings = mTextCache.Find( frame_index, display_base, ResultTextCache::TABULAR_TEXT );
+
+    if ( !strings )
+    {
+        std::vector<std::string> built( 1, BuildTabularText( GetFrame( frame_index ), display_base ) );
+        strings = mTextCache.Insert( frame_index, display_base, ResultTextCache::TABULAR_TEXT, std::move( built ) );
+    }
+
+    for ( const std::string& text : *strings )
+    {
+        AddTabularText( text.c_str() );
+    }
+#endif
+}
+
+std::string AsyncRgbLedAnalyzerResults::BuildTabularText( const Frame& frame, DisplayBase display_base )
+{
+    if ( frame.mFlags & FRAME_FLAG_PACKET )
+    {
+        // target content: [300 LEDs] #1a2b3c #4d5e6f ...
+        return "[" + std::to_string( FrameLedIndex( frame.mData2 ) ) + " LEDs] " +
+               PacketColorList( frame, PACKET_TEXT_COLORS );
+    }
+
+    char ledIndex[32];
+    FormatLedIndex( frame, ledIndex, sizeof( ledIndex ) );
     const RGBValue rgb = RGBValue::CreateFromU64( frame.mData1 );
 
     const int colorNumericBufferLength = 8;
@@ -136,10 +645,82 @@ void AsyncRgbLedAnalyzerResults::GenerateFrameTabularText( U64 frame_index, Disp
     GenerateRGBStrings( rgb, display_base, colorNumericBufferLength, redString, greenString, blueString );
 
     // target content: [13] 0x1A, 0x2B, 0x3C
-    char buf[64];
-    ::snprintf( buf, 64, "[%d] %s, %s, %s", ledIndex, redString, greenString, blueString );
-    AddTabularText( buf );
-#endif
+    char buf[96];
+    ::snprintf( buf, sizeof( buf ), "[%s] %s, %s, %s", ledIndex, redString, greenString, blueString );
+    return buf;
+}
+
+bool AsyncRgbLedAnalyzerResults::FindLedAtSample( U64 sample, LedPosition& position )
+{
+    const PacketIndex& index = mAnalyzer->GetPacketIndex();
+    U64 packet = 0;
+    PacketIndexEntry entry;
+
+    if ( !index.FindPacketAtSample( sample, packet ) || !index.Get( packet, entry ) ||
+            ( sample > entry.mEndSample ) )
+    {
+        return false;
+    }
+
+    // last frame of the packet starting at or before the sample
+    U64 low = entry.mFirstFrame;
+    U64 high = entry.mFirstFrame + entry.mFrameCount;
+
+    while ( high - low > 1 )
+    {
+        const U64 middle = low + ( high - low ) / 2;
+
+        if ( static_cast<U64>( GetFrame( middle ).mStartingSampleInclusive ) <= sample )
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    const Frame frame = GetFrame( low );
+
+    if ( sample > static_cast<U64>( frame.mEndingSampleInclusive ) )
+    {
+        // in the gap between two LEDs
+        return false;
+    }
+
+    position.mFrame = low;
+    position.mPacketId = FramePacketSequence( frame.mData2, frame.mType );
+    position.mLedIndex = FrameLedIndex( frame.mData2 );
+
+    if ( frame.mFlags & ( FRAME_FLAG_PACKET | FRAME_FLAG_RUN ) )
+    {
+        // invert InterpolateLedSample
+        const U64 ledCount = FrameLedCount( frame );
+        const U64 span = frame.mEndingSampleInclusive - frame.mStartingSampleInclusive + 1;
+        U64 led = ( ( sample - frame.mStartingSampleInclusive ) * ledCount ) / span;
+
+        while ( ( led + 1 < ledCount ) && ( InterpolateLedSample( frame, led + 1, ledCount ) <= sample ) )
+        {
+            ++led;
+        }
+
+        while ( ( led > 0 ) && ( InterpolateLedSample( frame, led, ledCount ) > sample ) )
+        {
+            --led;
+        }
+
+        // packet frames start at the first LED, run frames at their LED index
+        const U32 firstLed = ( frame.mFlags & FRAME_FLAG_RUN ) ? position.mLedIndex : 0;
+        position.mLedIndex = firstLed + static_cast<U32>( led );
+    }
+
+    return true;
+}
+
+U64 AsyncRgbLedAnalyzerResults::SampleAtTime( double seconds ) const
+{
+    const double sample = static_cast<double>( mAnalyzer->GetTriggerSample() ) + seconds * mAnalyzer->GetSampleRate();
+    return ( sample > 0.0 ) ? static_cast<U64>( sample + 0.5 ) : 0;
 }
 
 void AsyncRgbLedAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base )
@@ -3,9 +3,16 @@
 
 #include <AnalyzerResults.h>
 
+#include <string>
+#include <vector>
+
 #include "AsyncRgbLedHelpers.h" // for RGBValue
+#include "AsyncRgbLedColorArena.h"
+#include "AsyncRgbLedLazyDecode.h"
+#include "AsyncRgbLedTextCache.h"
 
 class AsyncRgbLedAnalyzer;
+class ExportBuffer;
 class AsyncRgbLedAnalyzerSettings;
 
 class AsyncRgbLedAnalyzerResults : public AnalyzerResults
@@ -21,14 +28,103 @@ class AsyncRgbLedAnalyzerResults : public AnalyzerResults
         void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) override;
         void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) override;
 
+        struct LedPosition
+        {
+            U64 mFrame = 0;
+            U32 mPacketId = 0;
+            U32 mLedIndex = 0;
+        };
+
+        /**
+         * @brief FindLedAtSample - the LED being sent at a sample, found by a
+         * binary search of the packet index and then of the packet's frames.
+         * Returns false if the sample isn't inside any packet.
+         */
+        bool FindLedAtSample( U64 sample, LedPosition& position );
+
+        /// sample at a time relative to the trigger, clamped to the start of the capture
+        U64 SampleAtTime( double seconds ) const;
+
+        const ResultTextCache& TextCache() const
+        {
+            return mTextCache;
+        }
+
     protected: //functions
 
     protected:  //vars
         AsyncRgbLedAnalyzerSettings* mSettings = nullptr;
         AsyncRgbLedAnalyzer* mAnalyzer = nullptr;
     private:
+        ResultTextCache mTextCache;
 
         void GenerateRGBStrings( const RGBValue& rgb, DisplayBase base, size_t bufSize, char* redBuf, char* greenBuff, char* blueBuf );
+
+        /// fixed-width records and a packet table, see AsyncRgbLedExport.h for the layout
+        void GenerateBinaryExportFile( const char* file );
+
+        /// LED index of a frame as text, or the index range of a run frame
+        static void FormatLedIndex( const Frame& frame, char* buf, size_t bufSize );
+
+        void BuildBubbleText( const Frame& frame, DisplayBase display_base, std::vector<std::string>& strings );
+        void BuildPacketBubbleText( const Frame& frame, std::vector<std::string>& strings );
+        std::string BuildTabularText( const Frame& frame, DisplayBase display_base );
+
+        /// the packet color readers of one export thread, so concurrent
+        /// chunks each keep their own decoded packet
+        struct PacketColorReader
+        {
+            explicit PacketColorReader( const AsyncRgbLedAnalyzer& analyzer );
+
+            LedColorArena::Reader mArena;
+            LazyPacketStore::Reader mLazy;
+        };
+
+        /// colors of a packet frame, from the color arena or decoded from its pulses
+        U32 GetPacketColors( const Frame& frame, U32 firstLed, U32 count, RGBValue* colors );
+        U32 GetPacketColors( const Frame& frame, PacketColorReader& reader, U32 firstLed, U32 count, RGBValue* colors );
+
+        /// web colors of the first LEDs of a packet frame
+        std::string PacketColorList( const Frame& frame, U32 maxColors );
+
+        /// call ledFunction( beginSample, endSample, ledIndex, rgb ) for each
+        /// LED of a frame, expanding packet frames through reader
+        template <typename LedFunction>
+        void ForEachLed( const Frame& frame, PacketColorReader& reader, LedFunction ledFunction );
+
+        /// the frames and LEDs selected by the export settings
+        struct ExportFilter
+        {
+            U64 mFirstFrame = 0;
+            U64 mEndFrame = 0;
+            U64 mStartSample = 0;
+            U64 mEndSample = ~0ULL;
+            U32 mFirstLed = 0;
+            U32 mLastLed = 0;
+
+            bool Includes( U64 beginSample, U64 ledIndex ) const
+            {
+                return ( beginSample >= mStartSample ) && ( beginSample <= mEndSample ) &&
+                       ( ledIndex >= mFirstLed ) && ( ledIndex <= mLastLed );
+            }
+        };
+
+        /// limit the export to the frames of the packets overlapping the time window
+        ExportFilter CreateExportFilter();
+
+        struct ExportPlan
+        {
+            // first frame of each export chunk, followed by the end frame
+            std::vector<U64> mChunkStarts;
+        };
+
+        ExportPlan PlanExport( const ExportFilter& filter );
+
+        /// format the export rows of a range of frames, called concurrently for different ranges
+        std::string FormatExportChunk( U64 firstFrame, U64 endFrame, const ExportFilter& filter, DisplayBase display_base );
+
+        /// format a color channel, with a fast path for the common display bases
+        static void AppendNumber( ExportBuffer& out, U16 value, DisplayBase base, U8 bitSize );
 };
 
 #endif //ASYNCRGBLED_ANALYZER_RESULTS
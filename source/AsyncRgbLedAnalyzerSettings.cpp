@@ -1,25 +1,75 @@
 #include "AsyncRgbLedAnalyzerSettings.h"
 
+#include <algorithm> // for std::max()
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
 
 #include <AnalyzerHelpers.h>
 
 const char* DEFAULT_CHANNEL_NAME = "Addressable LEDs (Async)";
 
-double operator "" _ns( unsigned long long x )
+namespace
 {
-    return x * 1e-9;
-}
+    // longest capture time between commits which can be set
+    const double MAX_COMMIT_INTERVAL_SEC = 60.0;
 
-double operator "" _us( unsigned long long x )
-{
-    return x * 1e-6;
+    bool IsValidCommitPolicy( U32 commitFrameCount, double commitIntervalSec )
+    {
+        return ( commitFrameCount >= 1 ) && ( commitFrameCount <= AsyncRgbLedAnalyzerSettings::MAX_COMMIT_FRAME_COUNT ) &&
+               ( commitIntervalSec >= 0.0 ) && ( commitIntervalSec <= MAX_COMMIT_INTERVAL_SEC );
+    }
+
+    /// parse an optional time in seconds, where empty text means none
+    bool ParseSecondsText( const char* text, bool& hasTime, double& seconds )
+    {
+        while ( *text == ' ' )
+        {
+            ++text;
+        }
+
+        if ( *text == '\0' )
+        {
+            hasTime = false;
+            return true;
+        }
+
+        char* end = nullptr;
+        const double value = std::strtod( text, &end );
+
+        while ( *end == ' ' )
+        {
+            ++end;
+        }
+
+        if ( ( end == text ) || ( *end != '\0' ) )
+        {
+            return false;
+        }
+
+        hasTime = true;
+        seconds = value;
+        return true;
+    }
+
+    void SetSecondsText( AnalyzerSettingInterfaceText* textInterface, bool hasTime, double seconds )
+    {
+        char buf[32] = "";
+
+        if ( hasTime )
+        {
+            ::snprintf( buf, sizeof( buf ), "%.9g", seconds );
+        }
+
+        textInterface->SetText( buf );
+    }
 }
 
+static_assert( AsyncRgbLedAnalyzerSettings::LED_LPD1886_12bit + 1 == LED_CONTROLLER_COUNT,
+               "Controller enum doesn't match the controller table" );
+
 AsyncRgbLedAnalyzerSettings::AsyncRgbLedAnalyzerSettings()
 {
-    InitControllerData();
-
     mInputChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
     mInputChannelInterface->SetTitleAndTooltip( "LED Channel", "Standard Addressable LEDs (Async)" );
     mInputChannelInterface->SetChannel( mInputChannel );
@@ -27,22 +77,93 @@ AsyncRgbLedAnalyzerSettings::AsyncRgbLedAnalyzerSettings()
     mControllerInterface.reset( new AnalyzerSettingInterfaceNumberList() );
     mControllerInterface->SetTitleAndTooltip( "LED Controller", "Specify the LED controller in use." );
 
-    int index = 0;
-
-    for ( const auto& controllerData : mControllers )
+    for ( size_t index = 0; index < LED_CONTROLLER_COUNT; ++index )
     {
-        mControllerInterface->AddNumber( index++, controllerData.mName.c_str(),
-                                         controllerData.mDescription.c_str() );
+        const auto& controllerData = GetLedControllerData( index );
+        mControllerInterface->AddNumber( static_cast<double>( index ), controllerData.mName,
+                                         controllerData.mDescription );
     }
 
     mControllerInterface->SetNumber( mLEDController );
 
+    mResultsModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mResultsModeInterface->SetTitleAndTooltip( "Results Mode", "Specify how decoded LEDs are stored." );
+    mResultsModeInterface->AddNumber( RESULTS_PER_LED, "One frame per LED", "Each LED is a separate frame" );
+    mResultsModeInterface->AddNumber( RESULTS_PER_PACKET, "One frame per packet",
+                                      "Each packet is a single frame, using far less memory on long captures" );
+    mResultsModeInterface->AddNumber( RESULTS_RUN_LENGTH, "Merge identical LEDs",
+                                      "Consecutive LEDs of the same color in a packet are a single frame" );
+    mResultsModeInterface->AddNumber( RESULTS_TIMELINE, "Packet timeline only",
+                                      "Only find the packets, decoding their LEDs when they are shown or exported" );
+    mResultsModeInterface->SetNumber( mResultsMode );
+
+    mExportStartInterface.reset( new AnalyzerSettingInterfaceText() );
+    mExportStartInterface->SetTitleAndTooltip( "Export From [s]",
+            "Only export LEDs sent at or after this time, relative to the trigger. Leave empty to export from the start." );
+    mExportEndInterface.reset( new AnalyzerSettingInterfaceText() );
+    mExportEndInterface->SetTitleAndTooltip( "Export To [s]",
+            "Only export LEDs sent at or before this time, relative to the trigger. Leave empty to export to the end." );
+
+    mExportFirstLedInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mExportFirstLedInterface->SetTitleAndTooltip( "Export First LED", "Index of the first LED of each packet to export." );
+    mExportFirstLedInterface->SetMin( 0 );
+    mExportFirstLedInterface->SetMax( MAX_EXPORT_LED );
+    mExportLastLedInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mExportLastLedInterface->SetTitleAndTooltip( "Export Last LED", "Index of the last LED of each packet to export." );
+    mExportLastLedInterface->SetMin( 0 );
+    mExportLastLedInterface->SetMax( MAX_EXPORT_LED );
+
+    mDecodeThreadsInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mDecodeThreadsInterface->SetTitleAndTooltip( "Decode Threads",
+            "Number of threads decoding the capture. With more than one, packets are decoded in parallel batches." );
+    mDecodeThreadsInterface->SetMin( 1 );
+    mDecodeThreadsInterface->SetMax( MAX_DECODE_THREADS );
+
+    mCommitFrameCountInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mCommitFrameCountInterface->SetTitleAndTooltip( "Commit Every N Frames",
+            "Decoded frames are shown once this many are waiting, or at the end of a packet." );
+    mCommitFrameCountInterface->SetMin( 1 );
+    mCommitFrameCountInterface->SetMax( MAX_COMMIT_FRAME_COUNT );
+    mCommitIntervalInterface.reset( new AnalyzerSettingInterfaceText() );
+    mCommitIntervalInterface->SetTitleAndTooltip( "Commit Interval [s]",
+            "Decoded frames are also shown once this much capture time has passed since they were last shown." );
+
+    mLiveLatencyInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mLiveLatencyInterface->SetTitleAndTooltip( "Live Latency [ms]",
+            "For watching live captures: commit LEDs within this much signal time, even part way through a packet, "
+            "and skip ahead to the next reset if decoding falls behind. Uses a single decode thread. Zero turns this off." );
+    mLiveLatencyInterface->SetMin( 0 );
+    mLiveLatencyInterface->SetMax( MAX_LIVE_LATENCY_MS );
+
+    mEdgeCacheInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mEdgeCacheInterface->SetTitleAndTooltip( "Edge Cache [MiB]",
+            "Memory kept for the capture's edges, so changing a setting decodes them again without reading the capture. "
+            "A continuous LED stream needs about 1.6 MB per second of capture at up to 100 MS/s, and twice that above; "
+            "edges past the limit are read from the capture again. Zero turns this off." );
+    mEdgeCacheInterface->SetMin( 0 );
+    mEdgeCacheInterface->SetMax( MAX_EDGE_CACHE_MIB );
+
+    UpdateInterfacesFromSettings();
+
     AddInterface( mInputChannelInterface.get() );
     AddInterface( mControllerInterface.get() );
-
-    AddExportOption( 0, "Export as text/csv file" );
-    AddExportExtension( 0, "text", "txt" );
-    AddExportExtension( 0, "csv", "csv" );
+    AddInterface( mResultsModeInterface.get() );
+    AddInterface( mExportStartInterface.get() );
+    AddInterface( mExportEndInterface.get() );
+    AddInterface( mExportFirstLedInterface.get() );
+    AddInterface( mExportLastLedInterface.get() );
+    AddInterface( mDecodeThreadsInterface.get() );
+    AddInterface( mCommitFrameCountInterface.get() );
+    AddInterface( mCommitIntervalInterface.get() );
+    AddInterface( mLiveLatencyInterface.get() );
+    AddInterface( mEdgeCacheInterface.get() );
+
+    AddExportOption( EXPORT_CSV, "Export as text/csv file" );
+    AddExportExtension( EXPORT_CSV, "text", "txt" );
+    AddExportExtension( EXPORT_CSV, "csv", "csv" );
+
+    AddExportOption( EXPORT_BINARY, "Export as binary file" );
+    AddExportExtension( EXPORT_BINARY, "binary", "bin" );
 
     ClearChannels();
     AddChannel( mInputChannel, DEFAULT_CHANNEL_NAME, false );
@@ -52,134 +173,58 @@ AsyncRgbLedAnalyzerSettings::~AsyncRgbLedAnalyzerSettings()
 {
 }
 
-void AsyncRgbLedAnalyzerSettings::InitControllerData()
+bool AsyncRgbLedAnalyzerSettings::SetSettingsFromInterfaces()
 {
-    // order of values here must correspond to the Controller enum
-    mControllers =
+    bool hasExportStart = false;
+    bool hasExportEnd = false;
+    double exportStartSec = 0.0;
+    double exportEndSec = 0.0;
+
+    if ( !ParseSecondsText( mExportStartInterface->GetText(), hasExportStart, exportStartSec ) ||
+            !ParseSecondsText( mExportEndInterface->GetText(), hasExportEnd, exportEndSec ) )
     {
-        // name, description, bits per channel, channels per frame, reset time nsec, low-speed data nsec, has high speed, high speed data nsec, color layout
+        SetErrorText( "Export times must be a number of seconds, or empty." );
+        return false;
+    }
 
-        // https://cdn-shop.adafruit.com/datasheets/WS2811.pdf
-        {
-            "WS2811", "Worldsemi 24-bit RGB controller", 8, 3,
-            {50_us, 50_us, 50_us},
-            {
-                // low-speed times
-                {{350_ns, 500_ns, 650_ns}, {1850_ns, 2000_ns, 2150_ns}},     // 0-bit times
-                {{1050_ns, 1200_ns, 1350_ns}, {1150_ns, 1300_ns, 1450_ns}},  // 1-bit times
-            },
-            true,
-            {
-                // high-speed times
-                {{175_ns, 250_ns, 325_ns}, {925_ns, 1000_ns, 1075_ns}},      // 0-bit times
-                {{525_ns, 600_ns, 675_ns}, {575_ns, 650_ns, 725_ns}}      // 1-bit times
-            },
-            LAYOUT_RGB
-        },
-        // https://cdn-shop.adafruit.com/datasheets/WS2812B.pdf
-		// http://www.seeedstudio.com/document/pdf/WS2812B%20Datasheet.pdf
-        {
-            "WS2812B", "Worldsemi 24-bit RGB integrated light-source", 8, 3,
-            {50_us, 50_us, 50_us},
-            {
-                // low-speed times
-                {{200_ns, 400_ns, 550_ns}, {700_ns, 850_ns, 1050_ns}},     // 0-bit times
-                {{650_ns, 800_ns, 1050_ns}, {200_ns, 450_ns, 600_ns}},  // 1-bit times
-            },
-            false, {{}, {}}, LAYOUT_GRB
-        },
-
-        // http://www.led-color.com/upload/201609/WS2813%20LED.pdf
-        {
-            "WS2813", "Worldsemi 24-bit RGB integrated light-source", 8, 3,
-            {50_us, 50_us, 50_us},
-            {
-                // low-speed times
-                {{300_ns, 375_ns, 450_ns}, {300_ns, 875_ns, 100_us}},     // 0-bit times
-                {{750_ns, 875_ns, 1000_ns}, {300_ns, 375_ns, 100_us}},  // 1-bit times
-            },
-            false, {{}, {}}, LAYOUT_GRB
-        },
-
-        // https://www.deskontrol.net/descargas/datasheets/TM1809.pdf
-        {
-            "TM1809", "Titan Micro 9-chanel 24-bit RGB controller", 8, 9,
-            {24_us, 24_us, 1.0},
-            {
-                // low-speed times
-                {{450_ns, 600_ns, 750_ns}, {1050_ns, 1200_ns, 1350_ns}},     // 0-bit times
-                {{1050_ns, 1200_ns, 1350_ns}, {450_ns, 600_ns, 750_ns}},  // 1-bit times
-            },
-            true,
-            {
-                // high-speed times
-                {{250_ns, 320_ns, 390_ns}, {530_ns, 600_ns, 670_ns}},      // 0-bit times
-                {{530_ns, 600_ns, 670_ns}, {250_ns, 320_ns, 390_ns}}       // 1-bit times
-            },
-            LAYOUT_RGB
-        },
-
-        // https://www.deskontrol.net/descargas/datasheets/TM1804.pdf
-        {
-            "TM1804", "Titan Micro 24-bit RGB controller", 8, 3,
-            {10_us, 10_us, 1.0},
-            {
-                // low-speed times
-                {{850_ns, 1_us, 1150_ns}, {1850_ns, 2_us, 2150_ns}},     // 0-bit times
-                {{1850_ns, 2_us, 2150_ns}, {850_ns, 1_us, 1150_ns}},     // 1-bit times
-            },
-            false, {{}, {}}, LAYOUT_RGB
-        },
-
-        // http://www.bestlightingbuy.com/pdf/UCS1903%20datasheet.pdf
-        {
-            "UCS1903", "UCS1903 24-bit RGB controller", 8, 3,
-            {24_us, 24_us, 1.0},
-            {
-                // low-speed times
-                {{350_ns, 500_ns, 650_ns}, {1850_ns, 2000_ns, 2150_ns}},     // 0-bit times
-                {{1850_ns, 2000_ns, 2150_ns}, {350_ns, 500_ns, 650_ns}},  // 1-bit times
-            },
-            true,
-            {
-                // high-speed times
-                {{175_ns, 250_ns, 325_ns}, {925_ns, 1000_ns, 1075_ns}},      // 0-bit times
-                {{925_ns, 1000_ns, 1075_ns}, {175_ns, 250_ns, 325_ns}}      // 1-bit times
-            },
-            LAYOUT_RGB
-        },
-
-        // https://www.syncrolight.co.uk/datasheets/LPD1886%20datasheet.pdf
-        {
-            "LPD1886 - 24 bit", "LPD1886 RGB controller in 24-bit mode", 8, 3,
-            {24_us, 30_us, 1.0},
-            {
-                // low-speed times
-                {{150_ns, 200_ns, 280_ns}, {500_ns, 600_ns, 10_us}},     // 0-bit times
-                {{450_ns, 600_ns, 9_us}, {150_ns, 200_ns, 10_us}},  // 1-bit times
-            },
-            false, {{}, {}}, LAYOUT_RGB
-        },
+    const int exportFirstLed = mExportFirstLedInterface->GetInteger();
+    const int exportLastLed = mExportLastLedInterface->GetInteger();
 
-        {
-            "LPD1886 - 36 bit", "LPD1886 RGB controller in 36-bit mode", 12, 3,
-            {24_us, 30_us, 1.0},
-            {
-                // low-speed times
-                {{150_ns, 200_ns, 280_ns}, {500_ns, 600_ns, 10_us}},     // 0-bit times
-                {{450_ns, 600_ns, 9_us}, {150_ns, 200_ns, 10_us}},  // 1-bit times
-            },
-            false, {{}, {}}, LAYOUT_RGB
-        },
-    };
-}
+    if ( ( exportFirstLed < 0 ) || ( exportFirstLed > exportLastLed ) ||
+            ( exportLastLed > static_cast<int>( MAX_EXPORT_LED ) ) )
+    {
+        SetErrorText( "The export LED range is invalid." );
+        return false;
+    }
+
+    const int commitFrameCount = mCommitFrameCountInterface->GetInteger();
+    bool hasCommitInterval = false;
+    double commitIntervalSec = 0.0;
+
+    if ( ( commitFrameCount < 1 ) ||
+            !ParseSecondsText( mCommitIntervalInterface->GetText(), hasCommitInterval, commitIntervalSec ) ||
+            !hasCommitInterval || !IsValidCommitPolicy( static_cast<U32>( commitFrameCount ), commitIntervalSec ) )
+    {
+        SetErrorText( "The commit interval must be from 0 to 60 seconds, with at least one frame per commit." );
+        return false;
+    }
 
-bool AsyncRgbLedAnalyzerSettings::SetSettingsFromInterfaces()
-{
     mInputChannel = mInputChannelInterface->GetChannel();
     // explicit cast to keep MSVC happy
     const int index = static_cast<int>( mControllerInterface->GetNumber() );
     mLEDController = static_cast<Controller>( index );
+    mResultsMode = static_cast<ResultsMode>( static_cast<int>( mResultsModeInterface->GetNumber() ) );
+    mHasExportStart = hasExportStart;
+    mExportStartSec = exportStartSec;
+    mHasExportEnd = hasExportEnd;
+    mExportEndSec = exportEndSec;
+    mExportFirstLed = static_cast<U32>( exportFirstLed );
+    mExportLastLed = static_cast<U32>( exportLastLed );
+    mDecodeThreadCount = static_cast<U32>( std::max( 1, mDecodeThreadsInterface->GetInteger() ) );
+    mCommitFrameCount = static_cast<U32>( commitFrameCount );
+    mCommitIntervalSec = commitIntervalSec;
+    mLiveLatencyMs = static_cast<U32>( std::max( 0, mLiveLatencyInterface->GetInteger() ) );
+    mEdgeCacheMiB = static_cast<U32>( std::max( 0, mEdgeCacheInterface->GetInteger() ) );
 
     ClearChannels();
     AddChannel( mInputChannel, DEFAULT_CHANNEL_NAME, true );
@@ -191,6 +236,16 @@ void AsyncRgbLedAnalyzerSettings::UpdateInterfacesFromSettings()
 {
     mInputChannelInterface->SetChannel( mInputChannel );
     mControllerInterface->SetNumber( mLEDController );
+    mResultsModeInterface->SetNumber( mResultsMode );
+    SetSecondsText( mExportStartInterface.get(), mHasExportStart, mExportStartSec );
+    SetSecondsText( mExportEndInterface.get(), mHasExportEnd, mExportEndSec );
+    mExportFirstLedInterface->SetInteger( static_cast<int>( mExportFirstLed ) );
+    mExportLastLedInterface->SetInteger( static_cast<int>( mExportLastLed ) );
+    mDecodeThreadsInterface->SetInteger( static_cast<int>( mDecodeThreadCount ) );
+    mCommitFrameCountInterface->SetInteger( static_cast<int>( mCommitFrameCount ) );
+    SetSecondsText( mCommitIntervalInterface.get(), true, mCommitIntervalSec );
+    mLiveLatencyInterface->SetInteger( static_cast<int>( mLiveLatencyMs ) );
+    mEdgeCacheInterface->SetInteger( static_cast<int>( mEdgeCacheMiB ) );
 }
 
 void AsyncRgbLedAnalyzerSettings::LoadSettings( const char* settings )
@@ -201,7 +256,67 @@ void AsyncRgbLedAnalyzerSettings::LoadSettings( const char* settings )
     U32 controllerInt;
     text_archive >> mInputChannel;
     text_archive >> controllerInt;
-    mLEDController = static_cast<Controller>( controllerInt );
+    if ( controllerInt < LED_CONTROLLER_COUNT )
+    {
+        mLEDController = static_cast<Controller>( controllerInt );
+    }
+
+    // commit policy values were added later, keep the defaults if absent
+    U32 commitFrameCount;
+    double commitIntervalSec;
+
+    if ( ( text_archive >> commitFrameCount ) && ( text_archive >> commitIntervalSec ) &&
+            IsValidCommitPolicy( commitFrameCount, commitIntervalSec ) )
+    {
+        mCommitFrameCount = commitFrameCount;
+        mCommitIntervalSec = commitIntervalSec;
+    }
+
+    U32 resultsModeInt;
+
+    if ( ( text_archive >> resultsModeInt ) && ( resultsModeInt <= RESULTS_TIMELINE ) )
+    {
+        mResultsMode = static_cast<ResultsMode>( resultsModeInt );
+    }
+
+    bool hasExportStart, hasExportEnd;
+    double exportStartSec, exportEndSec;
+    U32 exportFirstLed, exportLastLed;
+
+    if ( ( text_archive >> hasExportStart ) && ( text_archive >> exportStartSec ) &&
+            ( text_archive >> hasExportEnd ) && ( text_archive >> exportEndSec ) &&
+            ( text_archive >> exportFirstLed ) && ( text_archive >> exportLastLed ) &&
+            ( exportFirstLed <= exportLastLed ) && ( exportLastLed <= MAX_EXPORT_LED ) )
+    {
+        mHasExportStart = hasExportStart;
+        mExportStartSec = exportStartSec;
+        mHasExportEnd = hasExportEnd;
+        mExportEndSec = exportEndSec;
+        mExportFirstLed = exportFirstLed;
+        mExportLastLed = exportLastLed;
+    }
+
+    U32 decodeThreadCount;
+
+    if ( ( text_archive >> decodeThreadCount ) && ( decodeThreadCount >= 1 ) &&
+            ( decodeThreadCount <= MAX_DECODE_THREADS ) )
+    {
+        mDecodeThreadCount = decodeThreadCount;
+    }
+
+    U32 liveLatencyMs;
+
+    if ( ( text_archive >> liveLatencyMs ) && ( liveLatencyMs <= MAX_LIVE_LATENCY_MS ) )
+    {
+        mLiveLatencyMs = liveLatencyMs;
+    }
+
+    U32 edgeCacheMiB;
+
+    if ( ( text_archive >> edgeCacheMiB ) && ( edgeCacheMiB <= MAX_EDGE_CACHE_MIB ) )
+    {
+        mEdgeCacheMiB = edgeCacheMiB;
+    }
 
     ClearChannels();
     AddChannel( mInputChannel, DEFAULT_CHANNEL_NAME, true );
@@ -215,40 +330,62 @@ const char* AsyncRgbLedAnalyzerSettings::SaveSettings()
 
     text_archive << mInputChannel;
     text_archive << mLEDController;
+    text_archive << mCommitFrameCount;
+    text_archive << mCommitIntervalSec;
+    text_archive << mResultsMode;
+    text_archive << mHasExportStart;
+    text_archive << mExportStartSec;
+    text_archive << mHasExportEnd;
+    text_archive << mExportEndSec;
+    text_archive << mExportFirstLed;
+    text_archive << mExportLastLed;
+    text_archive << mDecodeThreadCount;
+    text_archive << mLiveLatencyMs;
+    text_archive << mEdgeCacheMiB;
 
     return SetReturnString( text_archive.GetString() );
 }
 
+const LedControllerData& AsyncRgbLedAnalyzerSettings::ControllerData() const
+{
+    return GetLedControllerData( mLEDController );
+}
+
 U8 AsyncRgbLedAnalyzerSettings::BitSize() const
 {
-    return mControllers.at( mLEDController ).mBitsPerChannel;
+    return ControllerData().mBitsPerChannel;
 }
 
 U8 AsyncRgbLedAnalyzerSettings::LEDChannelCount() const
 {
-    return mControllers.at( mLEDController ).mChannelCount;
+    return ControllerData().mChannelCount;
 }
 
 bool AsyncRgbLedAnalyzerSettings::IsHighSpeedSupported() const
 {
-    return mControllers.at( mLEDController ).mHasHighSpeed;
+    return ControllerData().mHasHighSpeed;
 }
 
 BitTiming AsyncRgbLedAnalyzerSettings::DataTiming( BitState value, bool isHighSpeed ) const
 {
-    const auto& c = mControllers.at( mLEDController );
+    const auto& c = ControllerData();
     assert( !isHighSpeed || c.mHasHighSpeed );
 
-    return isHighSpeed ? c.mDataTimingHighSpeed[value] :
-           c.mDataTiming[value];
+    return isHighSpeed ? c.mDataTimingHighSpeed[value].ToBitTiming() :
+           c.mDataTiming[value].ToBitTiming();
 }
 
 TimingTolerance AsyncRgbLedAnalyzerSettings::ResetTiming() const
 {
-    return mControllers.at( mLEDController ).mResetTiming;
+    return ControllerData().mResetTiming.ToTolerance();
 }
 
 ColorLayout AsyncRgbLedAnalyzerSettings::GetColorLayout() const
 {
-    return mControllers.at( mLEDController ).mLayout;
+    return ControllerData().mLayout;
+}
+
+DecoderTiming AsyncRgbLedAnalyzerSettings::SampleTiming( double sampleRateHz ) const
+{
+    return CreateDecoderTiming( ControllerData(), sampleRateHz );
 }
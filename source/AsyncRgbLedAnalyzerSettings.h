@@ -1,11 +1,10 @@
 #ifndef ASYNCRGBLED_ANALYZER_SETTINGS
 #define ASYNCRGBLED_ANALYZER_SETTINGS
 
-#include <vector>
-
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
 
+#include "AsyncRgbLedControllers.h"
 #include "AsyncRgbLedHelpers.h"
 
 class AsyncRgbLedAnalyzerSettings : public AnalyzerSettings
@@ -38,9 +37,68 @@ class AsyncRgbLedAnalyzerSettings : public AnalyzerSettings
             LED_LPD1886_12bit
         };
 
+        /// export_type_user_id values of the export options
+        enum ExportType
+        {
+            EXPORT_CSV = 0,
+            EXPORT_BINARY
+        };
+
+        enum ResultsMode
+        {
+            RESULTS_PER_LED = 0,
+            RESULTS_PER_PACKET,
+            RESULTS_RUN_LENGTH,
+            RESULTS_TIMELINE
+        };
+
+        /// highest LED index a frame can record
+        static const U32 MAX_EXPORT_LED = static_cast<U32>( FRAME_LED_INDEX_MASK );
+
+        static const U32 MAX_DECODE_THREADS = 64;
+
+        static const U32 MAX_COMMIT_FRAME_COUNT = 1 << 20;
+
+        static const U32 MAX_LIVE_LATENCY_MS = 1000;
+
+        static const U32 DEFAULT_EDGE_CACHE_MIB = 2048;
+        static const U32 MAX_EDGE_CACHE_MIB = 65536;
+
         Controller mLEDController = LED_WS2811;
+        ResultsMode mResultsMode = RESULTS_PER_LED;
         Channel mInputChannel = UNDEFINED_CHANNEL;
 
+        /// decoded frames are committed once this many are pending ...
+        U32 mCommitFrameCount = 256;
+
+        /// ... or once this much capture time has passed since the last commit
+        double mCommitIntervalSec = 0.01;
+
+        /// exports only include LEDs sent inside this window, in seconds
+        /// relative to the trigger; a limit which isn't set is unbounded
+        bool mHasExportStart = false;
+        double mExportStartSec = 0.0;
+        bool mHasExportEnd = false;
+        double mExportEndSec = 0.0;
+
+        /// ... and with an LED index inside this range
+        U32 mExportFirstLed = 0;
+        U32 mExportLastLed = MAX_EXPORT_LED;
+
+        /// with more than one thread, the capture is split at resets and the
+        /// pieces decoded in parallel
+        U32 mDecodeThreadCount = 1;
+
+        /// when non-zero, live captures are decoded in a single thread with
+        /// results committed within this much signal time, skipping ahead
+        /// to the next reset if decoding falls behind the capture
+        U32 mLiveLatencyMs = 0;
+
+        /// memory kept for the edges of the capture, so analysis runs again
+        /// without reading them from the channel data. A continuous LED
+        /// stream takes about 1.6 MB a second, at up to 100 MS/s.
+        U32 mEdgeCacheMiB = DEFAULT_EDGE_CACHE_MIB;
+
         /// bits ber LED channel, either 8 or 12 at present
         U8 BitSize() const;
 
@@ -55,31 +113,24 @@ class AsyncRgbLedAnalyzerSettings : public AnalyzerSettings
 
         ColorLayout GetColorLayout() const;
 
+        /// timing of the selected controller, converted to sample counts
+        DecoderTiming SampleTiming( double sampleRateHz ) const;
+
     protected:
-        void InitControllerData();
+        const LedControllerData& ControllerData() const;
 
         std::unique_ptr< AnalyzerSettingInterfaceChannel >  mInputChannelInterface;
         std::unique_ptr< AnalyzerSettingInterfaceNumberList >   mControllerInterface;
-
-        // we can't do direct defualt initialisation here, since according to C++11
-        // that makes this type non-POD and hence unsuitable for direct initialisation.
-        // C++14 fixes this.
-        struct LedControllerData
-        {
-            std::string mName;
-            std::string mDescription;
-            U8 mBitsPerChannel; // = 8;
-            U8 mChannelCount; // = 3;
-            TimingTolerance mResetTiming;
-            BitTiming mDataTiming[2]; // BIT_HIGH and BIT_LOW
-
-            bool mHasHighSpeed; // = true
-            BitTiming mDataTimingHighSpeed[2]; // BIT_HIGH and BIT_LOW
-
-            ColorLayout mLayout; // = LAYOUT_RGB
-        };
-
-        std::vector<LedControllerData> mControllers;
+        std::unique_ptr< AnalyzerSettingInterfaceNumberList >   mResultsModeInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceText >     mExportStartInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceText >     mExportEndInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mExportFirstLedInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mExportLastLedInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mDecodeThreadsInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mCommitFrameCountInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceText >     mCommitIntervalInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mLiveLatencyInterface;
+        std::unique_ptr< AnalyzerSettingInterfaceInteger >  mEdgeCacheInterface;
 };
 
 #endif //ASYNCRGBLED_ANALYZER_SETTINGS
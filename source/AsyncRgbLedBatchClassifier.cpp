@@ -0,0 +1,246 @@
+#include "AsyncRgbLedBatchClassifier.h"
+
+#include <algorithm> // for std::min/max()
+#include <cassert>
+#include <limits>
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    // GCC and Clang can compile each kernel for its own instruction set,
+    // and check the CPU at runtime
+    #define ASYNCRGBLED_X86_SIMD
+    #define ASYNCRGBLED_RUNTIME_AVX2
+    #define ASYNCRGBLED_TARGET( isa ) __attribute__( ( target( isa ) ) )
+    #include <immintrin.h>
+#elif defined( _M_X64 )
+    // SSE2 is always present on x64; MSVC has no per-function targets
+    #define ASYNCRGBLED_X86_SIMD
+    #define ASYNCRGBLED_TARGET( isa )
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    const S32 MAX_PULSE = std::numeric_limits<S32>::max() - 1;
+
+    S32 ClampLimit( U64 samples )
+    {
+        return static_cast<S32>( std::min<U64>( samples, MAX_PULSE ) );
+    }
+} // of anonymous namespace
+
+BatchThresholds BatchThresholds::Create( const DecoderTiming& timing, bool isHighSpeed )
+{
+    BatchThresholds result;
+
+    for ( const auto b : {BIT_LOW, BIT_HIGH} )
+    {
+        const BitSampleTiming& bit = timing.DataTiming( b, isHighSpeed );
+        const U64 negativeMinimum = std::max<U64>( bit.mNegative.mMinimum, U64( timing.mTooShortLowSamples ) + 1 );
+        const U64 negativeMaximum = std::min<U64>( bit.mNegative.mMaximum, timing.mResetSamples );
+
+        result.mPositiveMinimum[b] = ClampLimit( bit.mPositive.mMinimum );
+        result.mPositiveMaximum[b] = ClampLimit( bit.mPositive.mMaximum );
+        result.mNegativeMinimum[b] = ClampLimit( negativeMinimum );
+        result.mNegativeMaximum[b] = ClampLimit( negativeMaximum );
+    }
+
+    return result;
+}
+
+void ClassifyPulsesScalar( const U32* positive, const U32* negative, size_t count,
+                           const BatchThresholds& t, U64* bits, U64* valid )
+{
+    assert( count <= MAX_BATCH_PULSES );
+    U64 bitMask = 0;
+    U64 validMask = 0;
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const S32 p = static_cast<S32>( std::min<U32>( positive[i], MAX_PULSE + 1 ) );
+        const S32 n = static_cast<S32>( std::min<U32>( negative[i], MAX_PULSE + 1 ) );
+
+        // a positive pulse matching both bit values is a 0-bit, as in ReadBit
+        const bool isLow = ( p >= t.mPositiveMinimum[BIT_LOW] ) && ( p <= t.mPositiveMaximum[BIT_LOW] );
+        const bool isHigh = !isLow && ( p >= t.mPositiveMinimum[BIT_HIGH] ) && ( p <= t.mPositiveMaximum[BIT_HIGH] );
+        const int b = isHigh ? BIT_HIGH : BIT_LOW;
+        const bool ok = ( isLow || isHigh ) && ( n >= t.mNegativeMinimum[b] ) && ( n <= t.mNegativeMaximum[b] );
+
+        bitMask |= U64( isHigh ) << i;
+        validMask |= U64( ok ) << i;
+    }
+
+    *bits = bitMask;
+    *valid = validMask;
+}
+
+#if defined( ASYNCRGBLED_X86_SIMD )
+
+namespace
+{
+    ASYNCRGBLED_TARGET( "sse2" )
+    __m128i ClampPulses128( const U32* src )
+    {
+        // unsigned minimum isn't available in SSE2: anything with the top
+        // bit set is above MAX_PULSE, so replace it using a signed compare
+        const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src ) );
+        const __m128i limit = _mm_set1_epi32( MAX_PULSE + 1 );
+        const __m128i over = _mm_or_si128( _mm_cmplt_epi32( v, _mm_setzero_si128() ), _mm_cmpgt_epi32( v, limit ) );
+        return _mm_or_si128( _mm_and_si128( over, limit ), _mm_andnot_si128( over, v ) );
+    }
+
+    ASYNCRGBLED_TARGET( "sse2" )
+    __m128i InRange128( __m128i v, S32 minimum, S32 maximum )
+    {
+        // v >= min && v <= max, as two strict signed comparisons
+        return _mm_and_si128( _mm_cmpgt_epi32( v, _mm_set1_epi32( minimum - 1 ) ),
+                              _mm_cmplt_epi32( v, _mm_set1_epi32( maximum + 1 ) ) );
+    }
+
+    ASYNCRGBLED_TARGET( "sse2" )
+    void ClassifyPulsesSSE2( const U32* positive, const U32* negative, size_t count,
+                             const BatchThresholds& t, U64* bits, U64* valid )
+    {
+        assert( count <= MAX_BATCH_PULSES );
+        U64 bitMask = 0;
+        U64 validMask = 0;
+        size_t i = 0;
+
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            const __m128i p = ClampPulses128( positive + i );
+            const __m128i n = ClampPulses128( negative + i );
+
+            const __m128i isLow = InRange128( p, t.mPositiveMinimum[BIT_LOW], t.mPositiveMaximum[BIT_LOW] );
+            const __m128i isHigh = _mm_andnot_si128( isLow, InRange128( p, t.mPositiveMinimum[BIT_HIGH], t.mPositiveMaximum[BIT_HIGH] ) );
+            const __m128i ok = _mm_or_si128(
+                                   _mm_and_si128( isLow, InRange128( n, t.mNegativeMinimum[BIT_LOW], t.mNegativeMaximum[BIT_LOW] ) ),
+                                   _mm_and_si128( isHigh, InRange128( n, t.mNegativeMinimum[BIT_HIGH], t.mNegativeMaximum[BIT_HIGH] ) ) );
+
+            bitMask |= U64( _mm_movemask_ps( _mm_castsi128_ps( isHigh ) ) ) << i;
+            validMask |= U64( _mm_movemask_ps( _mm_castsi128_ps( ok ) ) ) << i;
+        }
+
+        if ( i < count )
+        {
+            U64 tailBits, tailValid;
+            ClassifyPulsesScalar( positive + i, negative + i, count - i, t, &tailBits, &tailValid );
+            bitMask |= tailBits << i;
+            validMask |= tailValid << i;
+        }
+
+        *bits = bitMask;
+        *valid = validMask;
+    }
+
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    ASYNCRGBLED_TARGET( "avx2" )
+    __m256i ClampPulses256( const U32* src )
+    {
+        const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( src ) );
+        return _mm256_min_epu32( v, _mm256_set1_epi32( MAX_PULSE + 1 ) );
+    }
+
+    ASYNCRGBLED_TARGET( "avx2" )
+    __m256i InRange256( __m256i v, S32 minimum, S32 maximum )
+    {
+        return _mm256_and_si256( _mm256_cmpgt_epi32( v, _mm256_set1_epi32( minimum - 1 ) ),
+                                 _mm256_cmpgt_epi32( _mm256_set1_epi32( maximum + 1 ), v ) );
+    }
+
+    ASYNCRGBLED_TARGET( "avx2" )
+    void ClassifyPulsesAVX2( const U32* positive, const U32* negative, size_t count,
+                             const BatchThresholds& t, U64* bits, U64* valid )
+    {
+        assert( count <= MAX_BATCH_PULSES );
+        U64 bitMask = 0;
+        U64 validMask = 0;
+        size_t i = 0;
+
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            const __m256i p = ClampPulses256( positive + i );
+            const __m256i n = ClampPulses256( negative + i );
+
+            const __m256i isLow = InRange256( p, t.mPositiveMinimum[BIT_LOW], t.mPositiveMaximum[BIT_LOW] );
+            const __m256i isHigh = _mm256_andnot_si256( isLow, InRange256( p, t.mPositiveMinimum[BIT_HIGH], t.mPositiveMaximum[BIT_HIGH] ) );
+            const __m256i ok = _mm256_or_si256(
+                                   _mm256_and_si256( isLow, InRange256( n, t.mNegativeMinimum[BIT_LOW], t.mNegativeMaximum[BIT_LOW] ) ),
+                                   _mm256_and_si256( isHigh, InRange256( n, t.mNegativeMinimum[BIT_HIGH], t.mNegativeMaximum[BIT_HIGH] ) ) );
+
+            bitMask |= U64( _mm256_movemask_ps( _mm256_castsi256_ps( isHigh ) ) ) << i;
+            validMask |= U64( _mm256_movemask_ps( _mm256_castsi256_ps( ok ) ) ) << i;
+        }
+
+        if ( i < count )
+        {
+            U64 tailBits, tailValid;
+            ClassifyPulsesSSE2( positive + i, negative + i, count - i, t, &tailBits, &tailValid );
+            bitMask |= tailBits << i;
+            validMask |= tailValid << i;
+        }
+
+        *bits = bitMask;
+        *valid = validMask;
+    }
+#endif // of ASYNCRGBLED_RUNTIME_AVX2
+} // of anonymous namespace
+
+#endif // of ASYNCRGBLED_X86_SIMD
+
+std::vector<BatchClassifier> SupportedBatchClassifiers()
+{
+    std::vector<BatchClassifier> result;
+    result.push_back( BatchClassifier{"scalar", &ClassifyPulsesScalar} );
+
+#if defined( ASYNCRGBLED_X86_SIMD )
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "sse2" ) )
+#endif
+    {
+        result.push_back( BatchClassifier{"sse2", &ClassifyPulsesSSE2} );
+    }
+
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    if ( __builtin_cpu_supports( "avx2" ) )
+    {
+        result.push_back( BatchClassifier{"avx2", &ClassifyPulsesAVX2} );
+    }
+#endif
+#endif
+
+    return result;
+}
+
+BatchClassifyFunction SelectBatchClassifier()
+{
+    return SupportedBatchClassifiers().back().mClassify;
+}
+
+namespace
+{
+    U64 ReverseBits( U64 v )
+    {
+        v = ( ( v >> 1 ) & 0x5555555555555555ULL ) | ( ( v & 0x5555555555555555ULL ) << 1 );
+        v = ( ( v >> 2 ) & 0x3333333333333333ULL ) | ( ( v & 0x3333333333333333ULL ) << 2 );
+        v = ( ( v >> 4 ) & 0x0F0F0F0F0F0F0F0FULL ) | ( ( v & 0x0F0F0F0F0F0F0F0FULL ) << 4 );
+        v = ( ( v >> 8 ) & 0x00FF00FF00FF00FFULL ) | ( ( v & 0x00FF00FF00FF00FFULL ) << 8 );
+        v = ( ( v >> 16 ) & 0x0000FFFF0000FFFFULL ) | ( ( v & 0x0000FFFF0000FFFFULL ) << 16 );
+        return ( v >> 32 ) | ( v << 32 );
+    }
+} // of anonymous namespace
+
+void PackChannelWords( U64 bits, U8 bitSize, U16* channels )
+{
+    assert( ( bitSize > 0 ) && ( bitSize <= 16 ) );
+    const U32 totalBits = 3 * bitSize;
+    const U64 wordMask = ( U64( 1 ) << bitSize ) - 1;
+
+    // pulse 0 is the MSB of the first word: reversing puts it at the top
+    const U64 msbFirst = ReverseBits( bits ) >> ( 64 - totalBits );
+
+    channels[0] = static_cast<U16>( ( msbFirst >> ( 2 * bitSize ) ) & wordMask );
+    channels[1] = static_cast<U16>( ( msbFirst >> bitSize ) & wordMask );
+    channels[2] = static_cast<U16>( msbFirst & wordMask );
+}
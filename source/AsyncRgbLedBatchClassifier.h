@@ -0,0 +1,61 @@
+#ifndef ASYNCRGBLED_BATCH_CLASSIFIER
+#define ASYNCRGBLED_BATCH_CLASSIFIER
+
+#include <AnalyzerTypes.h>
+
+#include <vector>
+
+#include "AsyncRgbLedHelpers.h"
+
+/**
+ * @brief BatchThresholds - pulse limits for one speed mode, in samples, in
+ * the form used by the batch classifiers. The too-short and reset limits
+ * for low pulses are folded into the negative ranges, so a pulse pair is a
+ * valid data bit if and only if it is inside the ranges for one bit value.
+ * Pulse lengths are clamped to the S32 range before comparing.
+ */
+struct BatchThresholds
+{
+    // indexed by BitState
+    S32 mPositiveMinimum[2];
+    S32 mPositiveMaximum[2];
+    S32 mNegativeMinimum[2];
+    S32 mNegativeMaximum[2];
+
+    static BatchThresholds Create( const DecoderTiming& timing, bool isHighSpeed );
+};
+
+/// largest number of pulses classified by one call
+const size_t MAX_BATCH_PULSES = 64;
+
+/**
+ * Classify count pulse pairs (count <= MAX_BATCH_PULSES). Bit i of bits is
+ * the value of pulse i, and bit i of valid is set if that pulse was a valid
+ * data bit. Bits of invalid pulses are undefined.
+ */
+typedef void ( *BatchClassifyFunction )( const U32* positive, const U32* negative, size_t count,
+        const BatchThresholds& thresholds, U64* bits, U64* valid );
+
+struct BatchClassifier
+{
+    const char* mName;
+    BatchClassifyFunction mClassify;
+};
+
+/// all implementations usable on this CPU, the portable scalar one first
+std::vector<BatchClassifier> SupportedBatchClassifiers();
+
+/// the fastest implementation usable on this CPU
+BatchClassifyFunction SelectBatchClassifier();
+
+void ClassifyPulsesScalar( const U32* positive, const U32* negative, size_t count,
+                           const BatchThresholds& thresholds, U64* bits, U64* valid );
+
+/**
+ * @brief PackChannelWords - split the bits of three consecutive channel words,
+ * as returned by a BatchClassifyFunction, into the words themselves. Each
+ * word is sent MSB first, in controller channel order.
+ */
+void PackChannelWords( U64 bits, U8 bitSize, U16* channels );
+
+#endif // of #define ASYNCRGBLED_BATCH_CLASSIFIER
@@ -0,0 +1,248 @@
+#include "AsyncRgbLedBitstream.h"
+
+#include <cassert>
+#include <cstring> // for memcpy
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    // GCC and Clang can compile each kernel for its own instruction set,
+    // and check the CPU at runtime
+    #define ASYNCRGBLED_X86_SIMD
+    #define ASYNCRGBLED_RUNTIME_AVX2
+    #define ASYNCRGBLED_TARGET( isa ) __attribute__( ( target( isa ) ) )
+    #include <immintrin.h>
+#elif defined( _M_X64 )
+    // SSE2 is always present on x64; MSVC has no per-function targets
+    #define ASYNCRGBLED_X86_SIMD
+    #define ASYNCRGBLED_TARGET( isa )
+    #include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER )
+    #include <intrin.h>
+#endif
+
+namespace
+{
+    U64 CountTrailingZeros( U64 value )
+    {
+        assert( value != 0 );
+#if defined( __GNUC__ ) || defined( __clang__ )
+        return static_cast<U64>( __builtin_ctzll( value ) );
+#elif defined( _M_X64 )
+        unsigned long index;
+        _BitScanForward64( &index, value );
+        return index;
+#else
+        U64 count = 0;
+
+        for ( ; ( value & 1 ) == 0; value >>= 1 )
+        {
+            ++count;
+        }
+
+        return count;
+#endif
+    }
+
+    U64 LoadPackedWord( const U8* packed )
+    {
+        U64 word;
+        std::memcpy( &word, packed, sizeof( word ) );
+        return word;
+    }
+
+    /// bit i is set where sample i differs from the sample before it
+    U64 TransitionMask( U64 word, U64 lastBit )
+    {
+        return word ^ ( ( word << 1 ) | lastBit );
+    }
+
+    size_t AppendEdges( U64 transitions, U64 firstSample, U64* edges, size_t edgeCount )
+    {
+        for ( ; transitions != 0; transitions &= transitions - 1 )
+        {
+            edges[edgeCount++] = firstSample + CountTrailingZeros( transitions );
+        }
+
+        return edgeCount;
+    }
+} // of anonymous namespace
+
+size_t ScanEdgesScalar( const U8* packed, size_t wordCount, U64 firstSample, U64* lastBit,
+                        U64* edges, size_t* edgeCount, size_t maxEdges )
+{
+    U64 previous = *lastBit;
+    size_t count = *edgeCount;
+    size_t w = 0;
+
+    for ( ; ( w < wordCount ) && ( maxEdges - count >= PACKED_WORD_SAMPLES ); ++w )
+    {
+        // idle words have no transitions, so cost just the mask
+        const U64 word = LoadPackedWord( packed + w * sizeof( U64 ) );
+        count = AppendEdges( TransitionMask( word, previous ), firstSample + w * PACKED_WORD_SAMPLES, edges, count );
+        previous = word >> 63;
+    }
+
+    *lastBit = previous;
+    *edgeCount = count;
+    return w;
+}
+
+#if defined( ASYNCRGBLED_X86_SIMD )
+
+namespace
+{
+    ASYNCRGBLED_TARGET( "sse2" )
+    size_t ScanEdgesSSE2( const U8* packed, size_t wordCount, U64 firstSample, U64* lastBit,
+                          U64* edges, size_t* edgeCount, size_t maxEdges )
+    {
+        U64 previous = *lastBit;
+        size_t count = *edgeCount;
+        size_t w = 0;
+
+        for ( ; ( w + 2 <= wordCount ) && ( maxEdges - count >= 2 * PACKED_WORD_SAMPLES ); w += 2 )
+        {
+            // shift both words up a sample, carrying the top bit of the
+            // first into the second
+            const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( packed + w * sizeof( U64 ) ) );
+            const __m128i carry = _mm_unpacklo_epi64( _mm_set_epi64x( 0, static_cast<long long>( previous ) ),
+                                  _mm_srli_epi64( v, 63 ) );
+            const __m128i transitions = _mm_xor_si128( v, _mm_or_si128( _mm_slli_epi64( v, 1 ), carry ) );
+
+            if ( _mm_movemask_epi8( _mm_cmpeq_epi8( transitions, _mm_setzero_si128() ) ) != 0xffff )
+            {
+                U64 masks[2];
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( masks ), transitions );
+                count = AppendEdges( masks[0], firstSample + w * PACKED_WORD_SAMPLES, edges, count );
+                count = AppendEdges( masks[1], firstSample + ( w + 1 ) * PACKED_WORD_SAMPLES, edges, count );
+            }
+
+            previous = LoadPackedWord( packed + ( w + 1 ) * sizeof( U64 ) ) >> 63;
+        }
+
+        *lastBit = previous;
+        *edgeCount = count;
+        return w + ScanEdgesScalar( packed + w * sizeof( U64 ), wordCount - w, firstSample + w * PACKED_WORD_SAMPLES,
+                                    lastBit, edges, edgeCount, maxEdges );
+    }
+
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    ASYNCRGBLED_TARGET( "avx2" )
+    size_t ScanEdgesAVX2( const U8* packed, size_t wordCount, U64 firstSample, U64* lastBit,
+                          U64* edges, size_t* edgeCount, size_t maxEdges )
+    {
+        U64 previous = *lastBit;
+        size_t count = *edgeCount;
+        size_t w = 0;
+
+        for ( ; ( w + 4 <= wordCount ) && ( maxEdges - count >= 4 * PACKED_WORD_SAMPLES ); w += 4 )
+        {
+            // the top bit of each word moves up a lane, and the last bit of
+            // the previous group goes into the first
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( packed + w * sizeof( U64 ) ) );
+            const __m256i topBits = _mm256_permute4x64_epi64( _mm256_srli_epi64( v, 63 ), _MM_SHUFFLE( 2, 1, 0, 3 ) );
+            const __m256i carry = _mm256_blend_epi32( topBits, _mm256_set_epi64x( 0, 0, 0, static_cast<long long>( previous ) ), 0x03 );
+            const __m256i transitions = _mm256_xor_si256( v, _mm256_or_si256( _mm256_slli_epi64( v, 1 ), carry ) );
+
+            if ( !_mm256_testz_si256( transitions, transitions ) )
+            {
+                U64 masks[4];
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( masks ), transitions );
+
+                for ( size_t i = 0; i < 4; ++i )
+                {
+                    count = AppendEdges( masks[i], firstSample + ( w + i ) * PACKED_WORD_SAMPLES, edges, count );
+                }
+            }
+
+            previous = LoadPackedWord( packed + ( w + 3 ) * sizeof( U64 ) ) >> 63;
+        }
+
+        *lastBit = previous;
+        *edgeCount = count;
+        return w + ScanEdgesScalar( packed + w * sizeof( U64 ), wordCount - w, firstSample + w * PACKED_WORD_SAMPLES,
+                                    lastBit, edges, edgeCount, maxEdges );
+    }
+#endif // of ASYNCRGBLED_RUNTIME_AVX2
+} // of anonymous namespace
+
+#endif // of ASYNCRGBLED_X86_SIMD
+
+std::vector<EdgeScanner> SupportedEdgeScanners()
+{
+    std::vector<EdgeScanner> result;
+    result.push_back( EdgeScanner{"scalar", &ScanEdgesScalar} );
+
+#if defined( ASYNCRGBLED_X86_SIMD )
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "sse2" ) )
+#endif
+    {
+        result.push_back( EdgeScanner{"sse2", &ScanEdgesSSE2} );
+    }
+
+#if defined( ASYNCRGBLED_RUNTIME_AVX2 )
+    if ( __builtin_cpu_supports( "avx2" ) )
+    {
+        result.push_back( EdgeScanner{"avx2", &ScanEdgesAVX2} );
+    }
+#endif
+#endif
+
+    return result;
+}
+
+EdgeScanFunction SelectEdgeScanner()
+{
+    return SupportedEdgeScanners().back().mScan;
+}
+
+PackedEdgeScanner::PackedEdgeScanner( const U8* data, U64 sampleCount, EdgeScanFunction scan ) :
+    mData( data ),
+    mSampleCount( sampleCount ),
+    mScan( scan )
+{
+    if ( mSampleCount > 0 )
+    {
+        mInitialLevel = ( mData[0] & 1 ) ? BIT_HIGH : BIT_LOW;
+    }
+
+    // no transition at the first sample
+    mLastBit = ( mInitialLevel == BIT_HIGH ) ? 1 : 0;
+}
+
+size_t PackedEdgeScanner::Next( U64* edges, size_t maxEdges )
+{
+    assert( maxEdges >= PACKED_WORD_SAMPLES );
+    const U64 wordCount = ( mSampleCount + PACKED_WORD_SAMPLES - 1 ) / PACKED_WORD_SAMPLES;
+    const U64 wholeWordCount = mSampleCount / PACKED_WORD_SAMPLES;
+    size_t found = 0;
+
+    while ( ( mWord < wholeWordCount ) && ( maxEdges - found >= PACKED_WORD_SAMPLES ) )
+    {
+        mWord += mScan( mData + mWord * sizeof( U64 ), static_cast<size_t>( wholeWordCount - mWord ),
+                        mWord * PACKED_WORD_SAMPLES, &mLastBit, edges, &found, maxEdges );
+    }
+
+    if ( ( mWord < wordCount ) && ( mWord == wholeWordCount ) && ( maxEdges - found >= PACKED_WORD_SAMPLES ) )
+    {
+        // the last word is partial, so it's read a byte at a time, without
+        // reading past the end of the data
+        const U64 tailSamples = mSampleCount - mWord * PACKED_WORD_SAMPLES;
+        const U64 firstByte = mWord * sizeof( U64 );
+        U64 word = 0;
+
+        for ( U64 b = 0; b < ( tailSamples + 7 ) / 8; ++b )
+        {
+            word |= static_cast<U64>( mData[firstByte + b] ) << ( 8 * b );
+        }
+
+        const U64 transitions = TransitionMask( word, mLastBit ) & ( ( U64( 1 ) << tailSamples ) - 1 );
+        found = AppendEdges( transitions, mWord * PACKED_WORD_SAMPLES, edges, found );
+        ++mWord;
+    }
+
+    return found;
+}
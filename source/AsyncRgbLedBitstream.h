@@ -0,0 +1,81 @@
+#ifndef ASYNCRGBLED_BITSTREAM
+#define ASYNCRGBLED_BITSTREAM
+
+#include <AnalyzerTypes.h>
+
+#include <cstddef>
+#include <vector>
+
+/// samples in one packed word
+const size_t PACKED_WORD_SAMPLES = 64;
+
+/**
+ * Find the transitions in wordCount whole words of packed samples, writing
+ * their sample numbers to edges from *edgeCount on. Sample i of a word is
+ * bit i, and firstSample is the sample number of bit 0 of the first word.
+ * *lastBit is the level of the sample before the first word, 0 or 1, and
+ * is updated.
+ *
+ * A word has up to 64 transitions, so scanning stops once fewer than 64
+ * entries of edges are left. Returns the number of words scanned.
+ */
+typedef size_t ( *EdgeScanFunction )( const U8* packed, size_t wordCount, U64 firstSample, U64* lastBit,
+                                       U64* edges, size_t* edgeCount, size_t maxEdges );
+
+struct EdgeScanner
+{
+    const char* mName;
+    EdgeScanFunction mScan;
+};
+
+/// all implementations usable on this CPU, the portable scalar one first
+std::vector<EdgeScanner> SupportedEdgeScanners();
+
+/// the fastest implementation usable on this CPU
+EdgeScanFunction SelectEdgeScanner();
+
+size_t ScanEdgesScalar( const U8* packed, size_t wordCount, U64 firstSample, U64* lastBit,
+                        U64* edges, size_t* edgeCount, size_t maxEdges );
+
+/**
+ * @brief PackedEdgeScanner - finds the transitions of a digital capture
+ * stored one bit per sample, packed LSB first into little-endian 64-bit
+ * words, so sample i is bit ( i % 64 ) of word ( i / 64 ). The data isn't
+ * copied, so it can be a memory-mapped file, and whole words are read in
+ * place, which needs a little-endian host.
+ */
+class PackedEdgeScanner
+{
+    public:
+        PackedEdgeScanner( const U8* data, U64 sampleCount, EdgeScanFunction scan = SelectEdgeScanner() );
+
+        BitState InitialLevel() const
+        {
+            return mInitialLevel;
+        }
+
+        U64 SampleCount() const
+        {
+            return mSampleCount;
+        }
+
+        /**
+         * @brief Next - write the sample numbers of up to maxEdges further
+         * transitions to edges, returning how many were found. maxEdges has
+         * to be at least PACKED_WORD_SAMPLES. Returns zero once the end of
+         * the capture is reached.
+         */
+        size_t Next( U64* edges, size_t maxEdges );
+
+    private:
+        const U8* mData;
+        U64 mSampleCount;
+        EdgeScanFunction mScan;
+        BitState mInitialLevel = BIT_LOW;
+
+        // the next word to scan, and the level of the sample before it
+        U64 mWord = 0;
+        U64 mLastBit = 0;
+};
+
+#endif // of #define ASYNCRGBLED_BITSTREAM
@@ -0,0 +1,260 @@
+#include "AsyncRgbLedColorArena.h"
+
+#include <algorithm> // for std::min/max(), std::copy
+#include <cassert>
+
+namespace
+{
+    // bits of the changed-LED bitmap written or read at a time
+    const U32 BITMAP_CHUNK = 32;
+}
+
+void LedColorArena::Clear( U8 bitSize, U32 keyframeInterval )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    assert( bitSize > 0 && bitSize <= 16 );
+    mBitSize = bitSize;
+    mKeyframeInterval = std::max<U32>( keyframeInterval, 1 );
+    mWords.clear();
+    mBitCount = 0;
+    mPackets.clear();
+    mPreviousColors.clear();
+    mDecoded = DecodedPacket();
+}
+
+U64 LedColorArena::AddPacket( const RGBValue* colors, U32 count )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    const bool isKeyframe = ( mPackets.size() % mKeyframeInterval ) == 0;
+    mPackets.push_back( PacketEntry{mBitCount, count, isKeyframe} );
+
+    if ( isKeyframe )
+    {
+        for ( U32 led = 0; led < count; ++led )
+        {
+            AppendBits( PackColor( colors[led] ), LedWidth() );
+        }
+    }
+    else
+    {
+        // compare by LED position with the previous packet; LEDs past its
+        // end count as changed
+        std::vector<U64> changed;
+
+        for ( U32 first = 0; first < count; first += BITMAP_CHUNK )
+        {
+            const U32 chunkEnd = std::min( count, first + BITMAP_CHUNK );
+            U64 bitmap = 0;
+
+            for ( U32 led = first; led < chunkEnd; ++led )
+            {
+                const U64 packed = PackColor( colors[led] );
+
+                if ( ( led >= mPreviousColors.size() ) || ( packed != PackColor( mPreviousColors[led] ) ) )
+                {
+                    bitmap |= 1ULL << ( led - first );
+                    changed.push_back( packed );
+                }
+            }
+
+            AppendBits( bitmap, chunkEnd - first );
+        }
+
+        for ( const U64 packed : changed )
+        {
+            AppendBits( packed, LedWidth() );
+        }
+    }
+
+    mPreviousColors.assign( colors, colors + count );
+    return mPackets.size() - 1;
+}
+
+U64 LedColorArena::PacketCount() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mPackets.size();
+}
+
+U32 LedColorArena::PacketLedCount( U64 packet ) const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return ( packet < mPackets.size() ) ? mPackets[packet].mLedCount : 0;
+}
+
+U32 LedColorArena::GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors ) const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if ( ( packet >= mPackets.size() ) || ( firstLed >= mPackets[packet].mLedCount ) )
+    {
+        return 0;
+    }
+
+    DecodePacket( packet, mDecoded );
+    return CopyColors( mDecoded, firstLed, count, colors );
+}
+
+U32 LedColorArena::Reader::GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors )
+{
+    if ( !mDecoded.mIsValid || ( mDecoded.mPacket != packet ) )
+    {
+        std::lock_guard<std::mutex> lock( mArena->mMutex );
+
+        if ( packet >= mArena->mPackets.size() )
+        {
+            return 0;
+        }
+
+        mArena->DecodePacket( packet, mDecoded );
+    }
+
+    // a packet never changes once added, so its colors are read without the lock
+    return CopyColors( mDecoded, firstLed, count, colors );
+}
+
+U32 LedColorArena::CopyColors( const DecodedPacket& decoded, U32 firstLed, U32 count, RGBValue* colors )
+{
+    const U32 ledCount = static_cast<U32>( decoded.mColors.size() );
+
+    if ( firstLed >= ledCount )
+    {
+        return 0;
+    }
+
+    const U32 available = std::min( count, ledCount - firstLed );
+    std::copy( decoded.mColors.begin() + firstLed, decoded.mColors.begin() + firstLed + available, colors );
+    return available;
+}
+
+U64 LedColorArena::StoredBits() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mBitCount;
+}
+
+U64 LedColorArena::PackColor( const RGBValue& color ) const
+{
+    const U64 channelMask = ( 1ULL << mBitSize ) - 1;
+    return ( color.red & channelMask ) |
+           ( ( color.green & channelMask ) << mBitSize ) |
+           ( ( color.blue & channelMask ) << ( mBitSize * 2 ) );
+}
+
+RGBValue LedColorArena::UnpackColor( U64 packed ) const
+{
+    const U64 channelMask = ( 1ULL << mBitSize ) - 1;
+    return RGBValue( static_cast<U16>( packed & channelMask ),
+                     static_cast<U16>( ( packed >> mBitSize ) & channelMask ),
+                     static_cast<U16>( ( packed >> ( mBitSize * 2 ) ) & channelMask ) );
+}
+
+void LedColorArena::DecodePacket( U64 packet, DecodedPacket& decoded ) const
+{
+    if ( decoded.mIsValid && ( decoded.mPacket == packet ) )
+    {
+        return;
+    }
+
+    U64 keyframe = packet;
+
+    while ( !mPackets[keyframe].mIsKeyframe )
+    {
+        --keyframe;
+    }
+
+    // continue from the last packet read if it's on the way, otherwise
+    // start again from the keyframe
+    U64 next = keyframe;
+
+    if ( decoded.mIsValid && ( decoded.mPacket >= keyframe ) && ( decoded.mPacket < packet ) )
+    {
+        next = decoded.mPacket + 1;
+    }
+
+    for ( ; next <= packet; ++next )
+    {
+        ApplyPacket( next, decoded.mColors );
+    }
+
+    decoded.mPacket = packet;
+    decoded.mIsValid = true;
+}
+
+void LedColorArena::ApplyPacket( U64 packet, std::vector<RGBValue>& colors ) const
+{
+    const PacketEntry& entry = mPackets[packet];
+    colors.resize( entry.mLedCount );
+
+    if ( entry.mIsKeyframe )
+    {
+        U64 position = entry.mFirstBit;
+
+        for ( U32 led = 0; led < entry.mLedCount; ++led, position += LedWidth() )
+        {
+            colors[led] = UnpackColor( ExtractBits( position, LedWidth() ) );
+        }
+
+        return;
+    }
+
+    U64 bitmapPosition = entry.mFirstBit;
+    U64 colorPosition = entry.mFirstBit + entry.mLedCount;
+
+    for ( U32 first = 0; first < entry.mLedCount; first += BITMAP_CHUNK )
+    {
+        const U32 chunkLength = std::min( entry.mLedCount - first, BITMAP_CHUNK );
+        U64 bitmap = ExtractBits( bitmapPosition, chunkLength );
+        bitmapPosition += chunkLength;
+
+        while ( bitmap != 0 )
+        {
+            U32 bit = 0;
+
+            while ( ( ( bitmap >> bit ) & 1 ) == 0 )
+            {
+                ++bit;
+            }
+
+            colors[first + bit] = UnpackColor( ExtractBits( colorPosition, LedWidth() ) );
+            colorPosition += LedWidth();
+            bitmap &= bitmap - 1;
+        }
+    }
+}
+
+void LedColorArena::AppendBits( U64 value, U32 width )
+{
+    assert( width > 0 && width < 64 );
+    const U32 offset = static_cast<U32>( mBitCount & 63 );
+
+    if ( offset == 0 )
+    {
+        mWords.push_back( value );
+    }
+    else
+    {
+        mWords.back() |= value << offset;
+
+        if ( offset + width > 64 )
+        {
+            mWords.push_back( value >> ( 64 - offset ) );
+        }
+    }
+
+    mBitCount += width;
+}
+
+U64 LedColorArena::ExtractBits( U64 position, U32 width ) const
+{
+    const size_t word = static_cast<size_t>( position >> 6 );
+    const U32 offset = static_cast<U32>( position & 63 );
+    U64 value = mWords[word] >> offset;
+
+    if ( offset + width > 64 )
+    {
+        value |= mWords[word + 1] << ( 64 - offset );
+    }
+
+    return value & ( ( 1ULL << width ) - 1 );
+}
@@ -0,0 +1,124 @@
+#ifndef ASYNCRGBLED_COLOR_ARENA
+#define ASYNCRGBLED_COLOR_ARENA
+
+#include <AnalyzerTypes.h>
+
+#include <mutex>
+#include <vector>
+
+#include "AsyncRgbLedHelpers.h"
+
+/**
+ * @brief LedColorArena - the LED colors of every packet, bit-packed to
+ * three channels of the controller bit size per LED. Used in packet mode,
+ * where each packet is a single frame referring to its colors here.
+ *
+ * Most packets are stored as a delta against the previous packet: a bitmap
+ * of the LEDs which changed, followed by only their colors. Every
+ * keyframe-interval packets the full colors are stored instead, so reading
+ * any packet applies a bounded number of deltas.
+ *
+ * The analysis thread appends packets while the UI thread reads them back,
+ * so all access is serialised by a mutex. Threads reading many packets,
+ * such as export chunks, each use a Reader.
+ */
+class LedColorArena
+{
+    private:
+        /// the full colors of one packet, rebuilt from its keyframe
+        struct DecodedPacket
+        {
+            std::vector<RGBValue> mColors;
+            U64 mPacket = 0;
+            bool mIsValid = false;
+        };
+
+    public:
+        static const U32 DEFAULT_KEYFRAME_INTERVAL = 32;
+
+        /// discard all packets, and set the bits per channel for new ones
+        void Clear( U8 bitSize, U32 keyframeInterval = DEFAULT_KEYFRAME_INTERVAL );
+
+        /// store the colors of one packet, returns the index of the packet
+        U64 AddPacket( const RGBValue* colors, U32 count );
+
+        U64 PacketCount() const;
+
+        /// number of LEDs in a packet, zero for an unknown packet
+        U32 PacketLedCount( U64 packet ) const;
+
+        /**
+         * @brief GetColors - unpack count colors of a packet, starting at LED
+         * firstLed. Returns the number of colors unpacked, which is less than
+         * count if the packet ends first.
+         */
+        U32 GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors ) const;
+
+        /// size of the packed color data, in bits
+        U64 StoredBits() const;
+
+        /**
+         * @brief Reader - reads packets with its own decoded packet, so
+         * readers on different threads don't evict each other's. Reading
+         * packets in order applies one delta each, and reading more of the
+         * last packet doesn't take the arena's lock. A reader is only valid
+         * until the arena is cleared.
+         */
+        class Reader
+        {
+            public:
+                explicit Reader( const LedColorArena& arena ) :
+                    mArena( &arena )
+                {
+                }
+
+                /// as LedColorArena::GetColors
+                U32 GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors );
+
+            private:
+                const LedColorArena* mArena;
+                DecodedPacket mDecoded;
+        };
+
+    private:
+        U32 LedWidth() const
+        {
+            return mBitSize * 3;
+        }
+
+        U64 PackColor( const RGBValue& color ) const;
+        RGBValue UnpackColor( U64 packed ) const;
+
+        void AppendBits( U64 value, U32 width );
+        U64 ExtractBits( U64 position, U32 width ) const;
+
+        /// rebuild the full colors of a packet, continuing from the packet
+        /// decoded before if it is on the way
+        void DecodePacket( U64 packet, DecodedPacket& decoded ) const;
+        void ApplyPacket( U64 packet, std::vector<RGBValue>& colors ) const;
+
+        static U32 CopyColors( const DecodedPacket& decoded, U32 firstLed, U32 count, RGBValue* colors );
+
+        struct PacketEntry
+        {
+            U64 mFirstBit;
+            U32 mLedCount;
+            bool mIsKeyframe;
+        };
+
+        mutable std::mutex mMutex;
+        U8 mBitSize = 8;
+        U32 mKeyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+        std::vector<U64> mWords;
+        U64 mBitCount = 0;
+        std::vector<PacketEntry> mPackets;
+
+        // colors of the last packet added, which the next delta is against
+        std::vector<RGBValue> mPreviousColors;
+
+        // colors of the last packet read back without a Reader, so
+        // reading packets in order only applies one delta each
+        mutable DecodedPacket mDecoded;
+};
+
+#endif // of #define ASYNCRGBLED_COLOR_ARENA
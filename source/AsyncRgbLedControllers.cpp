@@ -0,0 +1,265 @@
+#include "AsyncRgbLedControllers.h"
+
+#include <algorithm> // for std::min/max()
+#include <cmath> // for floor
+#include <stdexcept>
+
+namespace
+{
+
+constexpr U32 operator "" _ns( unsigned long long x )
+{
+    return static_cast<U32>( x );
+}
+
+constexpr U32 operator "" _us( unsigned long long x )
+{
+    return static_cast<U32>( x * 1000 );
+}
+
+constexpr U32 operator "" _ms( unsigned long long x )
+{
+    return static_cast<U32>( x * 1000000 );
+}
+
+// order of values here must correspond to the Controller enum
+constexpr LedControllerData CONTROLLERS[] =
+{
+    // name, description, bits per channel, channels per frame, reset time nsec, low-speed data nsec, has high speed, high speed data nsec, color layout
+
+    // https://cdn-shop.adafruit.com/datasheets/WS2811.pdf
+    {
+        "WS2811", "Worldsemi 24-bit RGB controller", 8, 3,
+        {50_us, 50_us, 50_us},
+        {
+            // low-speed times
+            {{350_ns, 500_ns, 650_ns}, {1850_ns, 2000_ns, 2150_ns}},     // 0-bit times
+            {{1050_ns, 1200_ns, 1350_ns}, {1150_ns, 1300_ns, 1450_ns}},  // 1-bit times
+        },
+        true,
+        {
+            // high-speed times
+            {{175_ns, 250_ns, 325_ns}, {925_ns, 1000_ns, 1075_ns}},      // 0-bit times
+            {{525_ns, 600_ns, 675_ns}, {575_ns, 650_ns, 725_ns}}      // 1-bit times
+        },
+        LAYOUT_RGB
+    },
+    // https://cdn-shop.adafruit.com/datasheets/WS2812B.pdf
+    // http://www.seeedstudio.com/document/pdf/WS2812B%20Datasheet.pdf
+    {
+        "WS2812B", "Worldsemi 24-bit RGB integrated light-source", 8, 3,
+        {50_us, 50_us, 50_us},
+        {
+            // low-speed times
+            {{200_ns, 400_ns, 550_ns}, {700_ns, 850_ns, 1050_ns}},     // 0-bit times
+            {{650_ns, 800_ns, 1050_ns}, {200_ns, 450_ns, 600_ns}},  // 1-bit times
+        },
+        false, {{}, {}}, LAYOUT_GRB
+    },
+
+    // http://www.led-color.com/upload/201609/WS2813%20LED.pdf
+    {
+        "WS2813", "Worldsemi 24-bit RGB integrated light-source", 8, 3,
+        {50_us, 50_us, 50_us},
+        {
+            // low-speed times
+            {{300_ns, 375_ns, 450_ns}, {300_ns, 875_ns, 100_us}},     // 0-bit times
+            {{750_ns, 875_ns, 1000_ns}, {300_ns, 375_ns, 100_us}},  // 1-bit times
+        },
+        false, {{}, {}}, LAYOUT_GRB
+    },
+
+    // https://www.deskontrol.net/descargas/datasheets/TM1809.pdf
+    {
+        "TM1809", "Titan Micro 9-chanel 24-bit RGB controller", 8, 9,
+        {24_us, 24_us, 1000_ms},
+        {
+            // low-speed times
+            {{450_ns, 600_ns, 750_ns}, {1050_ns, 1200_ns, 1350_ns}},     // 0-bit times
+            {{1050_ns, 1200_ns, 1350_ns}, {450_ns, 600_ns, 750_ns}},  // 1-bit times
+        },
+        true,
+        {
+            // high-speed times
+            {{250_ns, 320_ns, 390_ns}, {530_ns, 600_ns, 670_ns}},      // 0-bit times
+            {{530_ns, 600_ns, 670_ns}, {250_ns, 320_ns, 390_ns}}       // 1-bit times
+        },
+        LAYOUT_RGB
+    },
+
+    // https://www.deskontrol.net/descargas/datasheets/TM1804.pdf
+    {
+        "TM1804", "Titan Micro 24-bit RGB controller", 8, 3,
+        {10_us, 10_us, 1000_ms},
+        {
+            // low-speed times
+            {{850_ns, 1_us, 1150_ns}, {1850_ns, 2_us, 2150_ns}},     // 0-bit times
+            {{1850_ns, 2_us, 2150_ns}, {850_ns, 1_us, 1150_ns}},     // 1-bit times
+        },
+        false, {{}, {}}, LAYOUT_RGB
+    },
+
+    // http://www.bestlightingbuy.com/pdf/UCS1903%20datasheet.pdf
+    {
+        "UCS1903", "UCS1903 24-bit RGB controller", 8, 3,
+        {24_us, 24_us, 1000_ms},
+        {
+            // low-speed times
+            {{350_ns, 500_ns, 650_ns}, {1850_ns, 2000_ns, 2150_ns}},     // 0-bit times
+            {{1850_ns, 2000_ns, 2150_ns}, {350_ns, 500_ns, 650_ns}},  // 1-bit times
+        },
+        true,
+        {
+            // high-speed times
+            {{175_ns, 250_ns, 325_ns}, {925_ns, 1000_ns, 1075_ns}},      // 0-bit times
+            {{925_ns, 1000_ns, 1075_ns}, {175_ns, 250_ns, 325_ns}}      // 1-bit times
+        },
+        LAYOUT_RGB
+    },
+
+    // https://www.syncrolight.co.uk/datasheets/LPD1886%20datasheet.pdf
+    {
+        "LPD1886 - 24 bit", "LPD1886 RGB controller in 24-bit mode", 8, 3,
+        {24_us, 30_us, 1000_ms},
+        {
+            // low-speed times
+            {{150_ns, 200_ns, 280_ns}, {500_ns, 600_ns, 10_us}},     // 0-bit times
+            {{450_ns, 600_ns, 9_us}, {150_ns, 200_ns, 10_us}},  // 1-bit times
+        },
+        false, {{}, {}}, LAYOUT_RGB
+    },
+
+    {
+        "LPD1886 - 36 bit", "LPD1886 RGB controller in 36-bit mode", 12, 3,
+        {24_us, 30_us, 1000_ms},
+        {
+            // low-speed times
+            {{150_ns, 200_ns, 280_ns}, {500_ns, 600_ns, 10_us}},     // 0-bit times
+            {{450_ns, 600_ns, 9_us}, {150_ns, 200_ns, 10_us}},  // 1-bit times
+        },
+        false, {{}, {}}, LAYOUT_RGB
+    },
+};
+
+static_assert( sizeof( CONTROLLERS ) / sizeof( CONTROLLERS[0] ) == LED_CONTROLLER_COUNT,
+               "LED_CONTROLLER_COUNT doesn't match the controller table" );
+
+// compile-time validation of the table. C++11 constexpr functions are limited
+// to a single return statement, hence the expression style.
+
+constexpr bool IsOrdered( const PulseTimingNs& t )
+{
+    return ( t.mMinimumNs <= t.mNominalNs ) && ( t.mNominalNs <= t.mMaximumNs ) && ( t.mMinimumNs > 0 );
+}
+
+constexpr bool Overlaps( const PulseTimingNs& a, const PulseTimingNs& b )
+{
+    return ( a.mMinimumNs <= b.mMaximumNs ) && ( b.mMinimumNs <= a.mMaximumNs );
+}
+
+// the decoder picks the bit value from the high pulse alone, so the positive
+// windows of the 0-bit and 1-bit must be disjoint
+constexpr bool IsValidSpeed( const BitTimingNs* timing )
+{
+    return IsOrdered( timing[0].mPositive ) && IsOrdered( timing[0].mNegative ) &&
+           IsOrdered( timing[1].mPositive ) && IsOrdered( timing[1].mNegative ) &&
+           !Overlaps( timing[0].mPositive, timing[1].mPositive );
+}
+
+constexpr bool IsValidController( const LedControllerData& c )
+{
+    return ( ( c.mBitsPerChannel == 8 ) || ( c.mBitsPerChannel == 12 ) ) &&
+           ( c.mChannelCount > 0 ) && ( c.mChannelCount % 3 == 0 ) &&
+           IsOrdered( c.mResetTiming ) &&
+           IsValidSpeed( c.mDataTiming ) &&
+           ( !c.mHasHighSpeed || IsValidSpeed( c.mDataTimingHighSpeed ) );
+}
+
+constexpr bool AreValidControllers( size_t index )
+{
+    return ( index == LED_CONTROLLER_COUNT ) ||
+           ( IsValidController( CONTROLLERS[index] ) && AreValidControllers( index + 1 ) );
+}
+
+static_assert( AreValidControllers( 0 ), "invalid timing in the controller table" );
+
+double NanosecondsToSeconds( U32 ns )
+{
+    return ns * 1e-9;
+}
+
+} // of anonymous namespace
+
+TimingTolerance PulseTimingNs::ToTolerance() const
+{
+    return TimingTolerance( NanosecondsToSeconds( mMinimumNs ),
+                            NanosecondsToSeconds( mNominalNs ),
+                            NanosecondsToSeconds( mMaximumNs ) );
+}
+
+BitTiming BitTimingNs::ToBitTiming() const
+{
+    return BitTiming( mPositive.ToTolerance(), mNegative.ToTolerance() );
+}
+
+const LedControllerData& GetLedControllerData( size_t index )
+{
+    if ( index >= LED_CONTROLLER_COUNT )
+    {
+        throw std::out_of_range( "invalid LED controller index" );
+    }
+
+    return CONTROLLERS[index];
+}
+
+DecoderTiming CreateDecoderTiming( const LedControllerData& c, double sampleRateHz )
+{
+    const double halfSampleWidth = 0.5 / sampleRateHz;
+    DecoderTiming result;
+    result.mHasHighSpeed = c.mHasHighSpeed;
+
+    const int speedCount = c.mHasHighSpeed ? 2 : 1;
+
+    for ( int speed = 0; speed < speedCount; ++speed )
+    {
+        const BitTimingNs* controllerTiming = ( speed == 0 ) ? c.mDataTiming : c.mDataTimingHighSpeed;
+
+        for ( const auto b : {BIT_LOW, BIT_HIGH} )
+        {
+            const BitTiming bitTiming = controllerTiming[b].ToBitTiming();
+            auto& timing = result.mDataTiming[speed][b];
+            timing.mPositive = bitTiming.mPositiveTiming.ToSampleRange( sampleRateHz );
+            timing.mNegative = bitTiming.mNegativeTiming.ToSampleRange( sampleRateHz );
+            timing.mNominalNegative = static_cast<U64>( bitTiming.mNegativeTiming.mNominalSec * sampleRateHz );
+        }
+
+        result.mClassifier[speed].Build( result.mDataTiming[speed][BIT_LOW], result.mDataTiming[speed][BIT_HIGH] );
+    }
+
+    // the high-speed pulses are shorter, so they define the minimum when present
+    const BitTimingNs* fastestTiming = c.mHasHighSpeed ? c.mDataTimingHighSpeed : c.mDataTiming;
+    const double minimumLowSec = NanosecondsToSeconds( std::min( fastestTiming[BIT_LOW].mNegative.mMinimumNs,
+                                                                 fastestTiming[BIT_HIGH].mNegative.mMinimumNs ) );
+
+    const double resetMinimumSec = NanosecondsToSeconds( c.mResetTiming.mMinimumNs );
+    result.mTooShortLowSamples = static_cast<U32>( ( minimumLowSec - halfSampleWidth ) * sampleRateHz );
+    result.mResetSamples = static_cast<U32>( resetMinimumSec * sampleRateHz );
+
+    // largest low pulse which is still too short to be a reset, using the
+    // same half-sample allowance as TimingTolerance::WithinTolerance
+    const double syncResetSec = resetMinimumSec - halfSampleWidth;
+    U64 syncResetSamples = static_cast<U64>( std::max( 0.0, std::floor( syncResetSec * sampleRateHz ) ) );
+
+    while ( ( syncResetSamples + 1 ) / sampleRateHz <= syncResetSec )
+    {
+        ++syncResetSamples;
+    }
+
+    while ( ( syncResetSamples > 0 ) && ( syncResetSamples / sampleRateHz > syncResetSec ) )
+    {
+        --syncResetSamples;
+    }
+
+    result.mSyncResetSamples = syncResetSamples;
+    return result;
+}
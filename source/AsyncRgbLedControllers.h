@@ -0,0 +1,58 @@
+#ifndef ASYNCRGBLED_CONTROLLERS
+#define ASYNCRGBLED_CONTROLLERS
+
+#include <cstddef>
+
+#include <AnalyzerTypes.h>
+
+#include "AsyncRgbLedHelpers.h"
+
+/// pulse timing window in integer nanoseconds
+struct PulseTimingNs
+{
+    U32 mMinimumNs;
+    U32 mNominalNs;
+    U32 mMaximumNs;
+
+    TimingTolerance ToTolerance() const;
+};
+
+struct BitTimingNs
+{
+    PulseTimingNs mPositive;
+    PulseTimingNs mNegative;
+
+    BitTiming ToBitTiming() const;
+};
+
+// no default member initialisers here, since in C++11 they make this type
+// non-aggregate, and the controller table is built by aggregate initialisation.
+struct LedControllerData
+{
+    const char* mName;
+    const char* mDescription;
+    U8 mBitsPerChannel;
+    U8 mChannelCount;
+    PulseTimingNs mResetTiming;
+    BitTimingNs mDataTiming[2]; // BIT_LOW and BIT_HIGH
+
+    bool mHasHighSpeed;
+    BitTimingNs mDataTimingHighSpeed[2]; // BIT_LOW and BIT_HIGH
+
+    ColorLayout mLayout;
+};
+
+/// number of entries in the controller table, matching the settings Controller enum
+const size_t LED_CONTROLLER_COUNT = 8;
+
+/// entry of the static controller table, throws std::out_of_range on a bad index
+const LedControllerData& GetLedControllerData( size_t index );
+
+/**
+ * @brief CreateDecoderTiming - convert the timing of one controller into
+ * sample counts at the given sample rate. Needs nothing from the SDK beyond
+ * its types, so it can be shared by anything which decodes captures.
+ */
+DecoderTiming CreateDecoderTiming( const LedControllerData& controller, double sampleRateHz );
+
+#endif // ASYNCRGBLED_CONTROLLERS
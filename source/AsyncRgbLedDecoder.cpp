@@ -0,0 +1,618 @@
+#include "AsyncRgbLedDecoder.h"
+
+#include <cassert>
+#include <iostream>
+
+#include "AsyncRgbLedBatchClassifier.h"
+#include "AsyncRgbLedEdgeBuffer.h"
+
+//#define LED_LOGGING
+
+namespace
+{
+    // edges held waiting to be decoded; more than the longest LED
+    const size_t EDGE_BUFFER_SIZE = 4096;
+
+    /**
+     * the decoder for one controller shape. Edges are kept in a ring buffer
+     * where a low period longer than a reset is recorded as a placeholder
+     * edge just after the reset limit, followed by the real rising edge.
+     */
+    template <typename Controller>
+    class LedDecoderImpl : public LedDecoder
+    {
+        public:
+            explicit LedDecoderImpl( const DecoderTiming& timing );
+
+            void Start( U64 sample, DecoderOutput* output ) override;
+            void Push( const U64* edges, size_t count ) override;
+            void Idle( U64 sample ) override;
+
+        private:
+            struct RGBResult
+            {
+                bool mValid = false;
+                bool mIsReset = false;
+                RGBValue mRGB;
+                U64 mValueBeginSample = 0;
+                U64 mValueEndSample = 0;
+            };
+
+            struct ReadResult
+            {
+                bool mValid = false;
+                bool mIsReset = false;
+                BitState mBitValue = BIT_LOW;
+                U64 mBeginSample = 0;
+                U64 mEndSample = 0;
+            };
+
+            // edges needed to decode an LED without reaching a reset
+            static const size_t LED_EDGE_COUNT = 2 * 3 * Controller::BIT_SIZE + 1;
+
+            void PushEdge( U64 sample );
+            void PushResetPlaceholder();
+            void MakeRoom();
+            void Consume( size_t count );
+
+            void Decode();
+
+            bool CanReadLed() const
+            {
+                // a buffered reset ends the LED early if it's incomplete
+                return ( mEdges.Size() >= LED_EDGE_COUNT ) || ( mHasReset && ( mResetIndex >= mConsumedCount ) );
+            }
+
+            bool SynchronizeToReset();
+
+            RGBResult ReadRGBTriple();
+            bool ReadRGBTripleBatch( RGBResult& result );
+            ReadResult ReadBit();
+            bool DetectSpeedMode( U64 positiveSamples, U64 negativeSamples, BitState& value );
+
+            const DecoderTiming mTiming;
+            DecoderOutput* mOutput = nullptr;
+
+            // the same timing for whole-LED classification, indexed by [isHighSpeed]
+            BatchThresholds mBatchThresholds[2];
+            BatchClassifyFunction mClassifyPulses = nullptr;
+
+            EdgeRingBuffer mEdges;
+            U64 mPushedCount = 0;
+            U64 mConsumedCount = 0;
+
+            // the last edge decoded, reported as the end of the packet
+            U64 mConsumedSample = 0;
+
+            // line state after the last edge pushed
+            U64 mLastEdgeSample = 0;
+            bool mIsLineLow = true;
+            bool mIsInReset = false;
+
+            // index of the latest reset placeholder pushed
+            bool mHasReset = false;
+            U64 mResetIndex = 0;
+
+            bool mIsResyncNeeded = true;
+            bool mIsInPacket = false;
+            bool mFirstBitAfterReset = true;
+            bool mDidDetectHighSpeed = false;
+    };
+
+    template <typename Controller>
+    LedDecoderImpl<Controller>::LedDecoderImpl( const DecoderTiming& timing ) :
+        mTiming( timing ),
+        mEdges( EDGE_BUFFER_SIZE )
+    {
+        static_assert( LED_EDGE_COUNT + 2 <= EDGE_BUFFER_SIZE, "edge buffer can't hold an LED" );
+
+        mBatchThresholds[0] = BatchThresholds::Create( mTiming, false );
+
+        if ( Controller::HAS_HIGH_SPEED )
+        {
+            mBatchThresholds[1] = BatchThresholds::Create( mTiming, true );
+        }
+
+        mClassifyPulses = SelectBatchClassifier();
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::Start( U64 sample, DecoderOutput* output )
+    {
+        mOutput = output;
+        mEdges.Clear();
+
+        // the start acts as the falling edge before the first low period
+        mEdges.Push( sample );
+        mPushedCount = 1;
+        mConsumedCount = 0;
+        mConsumedSample = sample;
+        mLastEdgeSample = sample;
+        mIsLineLow = true;
+        mIsInReset = false;
+        mHasReset = false;
+        mResetIndex = 0;
+        mIsResyncNeeded = true;
+        mIsInPacket = false;
+        mFirstBitAfterReset = true;
+        mDidDetectHighSpeed = false;
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::Push( const U64* edges, size_t count )
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            MakeRoom();
+            PushEdge( edges[i] );
+        }
+
+        Decode();
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::Idle( U64 sample )
+    {
+        if ( mIsLineLow && !mIsInReset && ( sample >= mLastEdgeSample + mTiming.mResetSamples ) )
+        {
+            MakeRoom();
+            PushResetPlaceholder();
+        }
+
+        Decode();
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::PushEdge( U64 sample )
+    {
+        assert( sample >= mLastEdgeSample );
+
+        if ( mIsLineLow && !mIsInReset && ( sample - mLastEdgeSample > mTiming.mResetSamples ) )
+        {
+            PushResetPlaceholder();
+        }
+
+        mEdges.Push( sample );
+        ++mPushedCount;
+        mLastEdgeSample = sample;
+        mIsLineLow = !mIsLineLow;
+        mIsInReset = false;
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::PushResetPlaceholder()
+    {
+        // recorded just after the reset limit, so the packet before the reset
+        // can be finished without waiting for the next packet
+        mEdges.Push( mLastEdgeSample + mTiming.mResetSamples + 1 );
+        mResetIndex = mPushedCount++;
+        mHasReset = true;
+        mIsInReset = true;
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::MakeRoom()
+    {
+        // an edge may need a placeholder before it. A full buffer always
+        // holds a whole LED, so decoding frees some space.
+        if ( mEdges.Size() + 2 > EDGE_BUFFER_SIZE )
+        {
+            Decode();
+        }
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::Consume( size_t count )
+    {
+        mConsumedSample = mEdges.Peek( count - 1 );
+        mEdges.Consume( count );
+        mConsumedCount += count;
+    }
+
+    template <typename Controller>
+    void LedDecoderImpl<Controller>::Decode()
+    {
+        for ( ; ; )
+        {
+            if ( mIsResyncNeeded )
+            {
+                if ( !SynchronizeToReset() )
+                {
+                    return;
+                }
+
+                mIsResyncNeeded = false;
+            }
+
+            if ( !mIsInPacket )
+            {
+                mFirstBitAfterReset = true;
+                mIsInPacket = true;
+                mOutput->StartPacket();
+            }
+
+            if ( !CanReadLed() )
+            {
+                return;
+            }
+
+            const RGBResult result = ReadRGBTriple();
+
+            if ( result.mValid )
+            {
+                mOutput->AddLed( result.mRGB, result.mValueBeginSample, result.mValueEndSample,
+                                 Controller::HAS_HIGH_SPEED && mDidDetectHighSpeed );
+            }
+
+            // an invalid LED is an error, unless a reset cut it short
+            const bool isError = !result.mValid && !result.mIsReset;
+
+            if ( isError || result.mIsReset )
+            {
+#if defined(LED_LOGGING)
+                if ( isError )
+                {
+                    std::cerr << "failed to read LED before sample " << mConsumedSample << std::endl;
+                }
+#endif
+                mOutput->EndPacket( isError, mConsumedSample );
+                mIsInPacket = false;
+                mIsResyncNeeded = isError;
+            }
+        }
+    }
+
+    template <typename Controller>
+    bool LedDecoderImpl<Controller>::SynchronizeToReset()
+    {
+        // the read position is always at a falling edge here
+        while ( mEdges.Size() >= 2 )
+        {
+            const U64 lowSamples = mEdges.Peek( 1 ) - mEdges.Peek( 0 );
+
+            if ( lowSamples > mTiming.mResetSamples )
+            {
+                // it's a reset, we are done. Skip the placeholder edge too, ready
+                // for the first ReadRGB / ReadBit at the following rising edge
+                Consume( 2 );
+                return true;
+            }
+
+            if ( lowSamples > mTiming.mSyncResetSamples )
+            {
+                // just long enough to be a reset, and ended by a real rising edge
+                Consume( 1 );
+                return true;
+            }
+
+            // skip the low period and the following high pulse, to the next
+            // falling edge, which is our next candidate for the beginning of a RESET
+            Consume( 2 );
+        }
+
+        return false;
+    }
+
+    template <typename Controller>
+    bool LedDecoderImpl<Controller>::ReadRGBTripleBatch( RGBResult& result )
+    {
+        const size_t bitCount = 3 * Controller::BIT_SIZE;
+
+        if ( mEdges.Size() < LED_EDGE_COUNT )
+        {
+            // a reset is coming up, leave that to the bit-by-bit path
+            return false;
+        }
+
+        U32 positive[MAX_BATCH_PULSES];
+        U32 negative[MAX_BATCH_PULSES];
+
+        for ( size_t i = 0; i < bitCount; ++i )
+        {
+            const U64 fallingEdgeSample = mEdges.Peek( 2 * i + 1 );
+            positive[i] = ClampToU32( fallingEdgeSample - mEdges.Peek( 2 * i ) );
+            negative[i] = ClampToU32( mEdges.Peek( 2 * i + 2 ) - fallingEdgeSample );
+        }
+
+        U64 bits = 0;
+        U64 valid = 0;
+        const bool isHighSpeed = Controller::HAS_HIGH_SPEED && mDidDetectHighSpeed;
+        mClassifyPulses( positive, negative, bitCount, mBatchThresholds[isHighSpeed ? 1 : 0], &bits, &valid );
+
+        if ( valid != ( ( U64( 1 ) << bitCount ) - 1 ) )
+        {
+            // an invalid bit or a reset; the bit-by-bit path will report it
+            return false;
+        }
+
+        U16 channels[3];
+        PackChannelWords( bits, Controller::BIT_SIZE, channels );
+
+        result.mRGB = RGBValue::CreateFromControllerOrder<Controller::LAYOUT>( channels );
+        result.mValueBeginSample = mEdges.Peek( 0 );
+        result.mValueEndSample = mEdges.Peek( 2 * bitCount ) - 1;
+        result.mValid = true;
+        Consume( 2 * bitCount );
+        return true;
+    }
+
+    template <typename Controller>
+    auto LedDecoderImpl<Controller>::ReadRGBTriple() -> RGBResult
+    {
+        RGBResult result;
+
+        // once the speed mode is known, try to classify the whole LED value in
+        // one go. This only fails near resets and errors.
+        if ( !mFirstBitAfterReset && ReadRGBTripleBatch( result ) )
+        {
+            return result;
+        }
+
+        U16 channels[3] = {0, 0, 0};
+        int channel = 0;
+
+        for ( ; channel < 3; )
+        {
+            U16 value = 0;
+            int i = 0;
+
+            for ( ; i < Controller::BIT_SIZE; ++i )
+            {
+                auto bitResult = ReadBit();
+
+                if ( !bitResult.mValid )
+                {
+#if defined(LED_LOGGING)
+                    std::cerr << "RGB read failure at bit " << i << std::endl;
+#endif
+                    break;
+                }
+
+                // for the first bit of channel 0, record the beginning time
+                // for accurate frame positions in the results
+                if ( ( i == 0 ) && ( channel == 0 ) )
+                {
+                    result.mValueBeginSample = bitResult.mBeginSample;
+                }
+
+                result.mValueEndSample = bitResult.mEndSample;
+
+                // channel values are sent MSB first
+                value = static_cast<U16>( ( value << 1 ) | bitResult.mBitValue );
+                result.mIsReset = bitResult.mIsReset;
+
+                if ( result.mIsReset && ( ( channel < 2 ) || ( i + 1 < Controller::BIT_SIZE ) ) )
+                {
+                    // the packet ended part way through this LED; the next bit
+                    // belongs to the following packet
+                    break;
+                }
+            }
+
+            if ( i == Controller::BIT_SIZE )
+            {
+                // we saw a complete channel, save it
+                channels[channel++] = value;
+            }
+            else
+            {
+                // partial data due to reset or invalid timing, discard
+                break;
+            }
+        }
+
+        if ( channel == 3 )
+        {
+            // we saw three complete channels, we can use this
+            result.mRGB = RGBValue::CreateFromControllerOrder<Controller::LAYOUT>( channels );
+            result.mValid = true;
+        } // in all other cases, mValid stays false - no RGB data was written
+
+        return result;
+    }
+
+    template <typename Controller>
+    auto LedDecoderImpl<Controller>::ReadBit() -> ReadResult
+    {
+        ReadResult result;
+        result.mValid = false;
+
+        // the read position is at a rising edge. We need that, the falling edge,
+        // and the edge (or reset placeholder) which ends the low period
+        assert( mEdges.Size() >= 3 );
+        result.mBeginSample = mEdges.Peek( 0 );
+        const U64 fallingEdgeSample = mEdges.Peek( 1 );
+        const U64 lowEndSample = mEdges.Peek( 2 );
+        const U64 highSamples = fallingEdgeSample - result.mBeginSample;
+        const U64 lowSamples = lowEndSample - fallingEdgeSample;
+
+        // folds to false for controllers without a high-speed mode
+        const bool isHighSpeed = Controller::HAS_HIGH_SPEED && mDidDetectHighSpeed;
+
+        if ( mFirstBitAfterReset )
+        {
+            // we can't classify yet, need to wait until we have the low pulse timing
+        }
+        else
+        {
+            // clasify based on existing value
+            // ensure consistency with previously detected speed setting
+            const U8 positiveClass = mTiming.Classifier( isHighSpeed ).ClassifyPositive( highSamples );
+
+            if ( positiveClass & PULSE_BIT_LOW )
+            {
+                result.mBitValue = BIT_LOW;
+            }
+            else if ( positiveClass & PULSE_BIT_HIGH )
+            {
+                result.mBitValue = BIT_HIGH;
+            }
+            else
+            {
+#if defined(LED_LOGGING)
+                std::cerr << "positive pulse timing doesn't match detected speed mode" << std::endl;
+                std::cerr << "\tdetected: " << (mDidDetectHighSpeed ? "Hi-speed" : "Normal") << std::endl;
+                std::cerr << "\t" << highSamples << " samples" << std::endl;
+#endif
+                Consume( 1 );
+                return result; // invalid result, reset required
+            }
+        }
+
+        // check for a too-short low timing
+        if ( lowSamples <= mTiming.mTooShortLowSamples )
+        {
+#if defined(LED_LOGGING)
+            std::cerr << "too short low pulse, invalid bit" << std::endl;
+            std::cerr << "\t" << lowSamples << " samples" << std::endl;
+#endif
+            // leave the read position at the next falling edge, for resync
+            Consume( 3 );
+            return result; // invalid result, reset required
+        }
+
+        // check for a low period exceeding the minimum reset time
+        // if we exceed that, this is a reset
+        if ( lowSamples > mTiming.mResetSamples )
+        {
+            // if we see a single bit in between resets, we can't decode the speed,
+            // but this is meaningless anyway, so return an error
+            if ( mFirstBitAfterReset )
+            {
+#if defined(LED_LOGGING)
+                std::cerr << "No complete bit between resets, can't decode" << std::endl;
+#endif
+                Consume( 1 );
+                return result; // return invalid
+            }
+
+            // consume the reset placeholder as well as this bit. The packet
+            // ends at the falling edge starting the reset, not the placeholder.
+            Consume( 3 );
+            mConsumedSample = fallingEdgeSample;
+            result.mIsReset = true;
+
+            // if this bit is also a reset, we can't check the low time since it
+            // will exceed the maximums, but we still want to accept that case
+            // as valid
+            result.mValid = true;
+
+            // use the nominal negative pulse timing for the frame ending.
+            result.mEndSample = fallingEdgeSample + mTiming.DataTiming( result.mBitValue, isHighSpeed ).mNominalNegative;
+            return result;
+        }
+
+        Consume( 2 );
+
+        // the -1 is so the end of this frame, and start of the next, don't
+        // overlap.
+        result.mEndSample = lowEndSample - 1;
+
+        if ( mFirstBitAfterReset )
+        {
+            // two-way classification. This is necessary because the the 0-data
+            // positive pulse of low-speed mode can match the 1-data positive pulse
+            // in high speed mode, for some controllers. Hence we need to correlate
+            // the high and low times to detect the speed mode
+
+            // this also sets mBitValue correct as a side-effect of the detection
+            result.mValid = DetectSpeedMode( highSamples, lowSamples, result.mBitValue );
+        }
+        else
+        {
+            // already detected the speed mode, ensure consistency
+            if ( mTiming.Classifier( isHighSpeed ).ClassifyNegative( lowSamples ) & PulseClassFor( result.mBitValue ) )
+            {
+                // we are good
+                result.mValid = true;
+            }
+            else
+            {
+#if defined(LED_LOGGING)
+                // we could do further classification here on the error, eg speed mismatch,
+                // or bit value mismatch
+                std::cerr << "negative pulse timing doesn't match positive pulse" << std::endl;
+                std::cerr << "\tdetected: " << (mDidDetectHighSpeed ? "Hi-speed" : "Normal") << std::endl;
+                std::cerr << "\t" << highSamples << " / " << lowSamples << " samples" << std::endl;
+#endif
+                result.mValid = false;
+            }
+        }
+
+        if ( !result.mValid )
+        {
+            // step past the rising edge, so resync starts from a falling edge
+            Consume( 1 );
+        }
+
+        return result;
+    }
+
+    template <typename Controller>
+    bool LedDecoderImpl<Controller>::DetectSpeedMode( U64 positiveSamples, U64 negativeSamples, BitState& value )
+    {
+        // low speed first, then high speed if the controller supports it
+        for ( const bool isHighSpeed : {false, true} )
+        {
+            if ( isHighSpeed && !Controller::HAS_HIGH_SPEED )
+            {
+                break;
+            }
+
+            const PulseClassifier& classifier = mTiming.Classifier( isHighSpeed );
+            const U8 matches = classifier.ClassifyPositive( positiveSamples ) & classifier.ClassifyNegative( negativeSamples );
+
+            if ( matches != PULSE_INVALID )
+            {
+                mDidDetectHighSpeed = isHighSpeed;
+                value = ( matches & PULSE_BIT_LOW ) ? BIT_LOW : BIT_HIGH;
+                mFirstBitAfterReset = false;
+                return true;
+            }
+        }
+
+        mDidDetectHighSpeed = false;
+#if defined(LED_LOGGING)
+        std::cerr << "failed to classify: " << positiveSamples << "/" << negativeSamples << " samples" << std::endl;
+#endif
+        return false;
+    }
+
+    template <U8 BitSize, ColorLayout Layout>
+    std::unique_ptr<LedDecoder> CreateForLayout( const DecoderTiming& timing )
+    {
+        if ( timing.mHasHighSpeed )
+        {
+            return std::unique_ptr<LedDecoder>( new LedDecoderImpl< ControllerTraits<BitSize, Layout, true> >( timing ) );
+        }
+
+        return std::unique_ptr<LedDecoder>( new LedDecoderImpl< ControllerTraits<BitSize, Layout, false> >( timing ) );
+    }
+
+    template <U8 BitSize>
+    std::unique_ptr<LedDecoder> CreateForBitSize( const DecoderTiming& timing, ColorLayout layout )
+    {
+        switch ( layout )
+        {
+            case LAYOUT_GRB:
+                return CreateForLayout<BitSize, LAYOUT_GRB>( timing );
+
+            case LAYOUT_RGB:
+            default:
+                return CreateForLayout<BitSize, LAYOUT_RGB>( timing );
+        }
+    }
+}
+
+std::unique_ptr<LedDecoder> LedDecoder::Create( const DecoderTiming& timing, U8 bitSize, ColorLayout layout )
+{
+    switch ( bitSize )
+    {
+        case 12:
+            return CreateForBitSize<12>( timing, layout );
+
+        default:
+            assert( bitSize == 8 );
+            return CreateForBitSize<8>( timing, layout );
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ASYNCRGBLED_DECODER
+#define ASYNCRGBLED_DECODER
+
+#include <AnalyzerTypes.h>
+
+#include <memory>
+
+#include "AsyncRgbLedHelpers.h"
+
+/**
+ * @brief DecoderOutput - receives the packets and LEDs found by an
+ * LedDecoder, in sample order.
+ */
+class DecoderOutput
+{
+    public:
+        virtual ~DecoderOutput() = default;
+
+        /// a packet starts once a reset has been found
+        virtual void StartPacket() = 0;
+
+        virtual void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed ) = 0;
+
+        /// the packet ended at a reset, or at an invalid bit if isError
+        virtual void EndPacket( bool isError, U64 endSample ) = 0;
+};
+
+/**
+ * @brief LedDecoder - the bit, LED and packet state machine, fed with edge
+ * sample numbers as they become available rather than reading them itself.
+ * Edges can be pushed in batches of any size; bits which aren't complete
+ * yet are kept until the following edges arrive.
+ *
+ * The line is low when decoding starts, so the first edge pushed is a
+ * rising edge, and a reset has to be found before any LED is decoded.
+ * Create() returns an implementation specialised for the controller shape.
+ */
+class LedDecoder
+{
+    public:
+        static std::unique_ptr<LedDecoder> Create( const DecoderTiming& timing, U8 bitSize, ColorLayout layout );
+
+        virtual ~LedDecoder() = default;
+
+        /// forget all state, with the line low from sample
+        virtual void Start( U64 sample, DecoderOutput* output ) = 0;
+
+        /// decode the next edges, alternating rising and falling
+        virtual void Push( const U64* edges, size_t count ) = 0;
+
+        /**
+         * @brief Idle - the line has not changed up to sample. This ends a
+         * reset without waiting for the edge after it, so the packet before
+         * the reset is finished.
+         */
+        virtual void Idle( U64 sample ) = 0;
+};
+
+#endif // of #define ASYNCRGBLED_DECODER
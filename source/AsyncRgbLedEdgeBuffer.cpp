@@ -0,0 +1,20 @@
+#include "AsyncRgbLedEdgeBuffer.h"
+
+EdgeRingBuffer::EdgeRingBuffer( size_t capacity )
+{
+    size_t size = 1;
+
+    while ( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    mSamples.resize( size );
+    mMask = size - 1;
+}
+
+void EdgeRingBuffer::Clear()
+{
+    mReadIndex = 0;
+    mWriteIndex = 0;
+}
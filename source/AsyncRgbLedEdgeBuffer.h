@@ -0,0 +1,59 @@
+#ifndef ASYNCRGBLED_EDGE_BUFFER
+#define ASYNCRGBLED_EDGE_BUFFER
+
+#include <AnalyzerTypes.h>
+
+#include <cassert>
+#include <vector>
+
+/**
+ * @brief EdgeRingBuffer - fixed-size FIFO of transition sample numbers.
+ * Edges are pulled from the channel data in batches and pushed here, and
+ * the decoder reads pulse lengths back out by peeking relative to the
+ * current read position.
+ */
+class EdgeRingBuffer
+{
+    public:
+        /// capacity is rounded up to a power of two
+        explicit EdgeRingBuffer( size_t capacity );
+
+        void Clear();
+
+        size_t Size() const
+        {
+            return static_cast<size_t>( mWriteIndex - mReadIndex );
+        }
+
+        bool Full() const
+        {
+            return Size() == mSamples.size();
+        }
+
+        void Push( U64 sample )
+        {
+            assert( !Full() );
+            mSamples[mWriteIndex++ & mMask] = sample;
+        }
+
+        /// sample number of the edge offset places after the read position
+        U64 Peek( size_t offset ) const
+        {
+            assert( offset < Size() );
+            return mSamples[( mReadIndex + offset ) & mMask];
+        }
+
+        void Consume( size_t count )
+        {
+            assert( count <= Size() );
+            mReadIndex += count;
+        }
+
+    private:
+        std::vector<U64> mSamples;
+        U64 mMask = 0;
+        U64 mReadIndex = 0;
+        U64 mWriteIndex = 0;
+};
+
+#endif // of #define ASYNCRGBLED_EDGE_BUFFER
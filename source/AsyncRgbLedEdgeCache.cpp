@@ -0,0 +1,107 @@
+#include "AsyncRgbLedEdgeCache.h"
+
+#include <cassert>
+
+namespace
+{
+    const size_t BLOCK_BYTES = 1 << 20;
+
+    // the longest encoding of a 64-bit delta
+    const size_t MAX_DELTA_BYTES = 10;
+}
+
+EdgeCache::EdgeCache( size_t maxBytes ) :
+    mMaxBytes( maxBytes )
+{
+}
+
+void EdgeCache::Clear( U64 startSample )
+{
+    std::vector<std::vector<U8>>().swap( mBlocks );
+    mByteSize = 0;
+    mEdgeCount = 0;
+    mStartSample = startSample;
+    mLastEdge = startSample;
+    mIsFull = false;
+}
+
+size_t EdgeCache::Append( const U64* edges, size_t count )
+{
+    for ( size_t i = 0; i < count; ++i )
+    {
+        if ( mIsFull || ( mByteSize + MAX_DELTA_BYTES > mMaxBytes ) )
+        {
+            mIsFull = true;
+            return i;
+        }
+
+        // an encoded delta never spans two blocks
+        if ( mBlocks.empty() || ( mBlocks.back().size() + MAX_DELTA_BYTES > BLOCK_BYTES ) )
+        {
+            mBlocks.emplace_back();
+            mBlocks.back().reserve( BLOCK_BYTES );
+        }
+
+        assert( edges[i] > mLastEdge );
+        std::vector<U8>& block = mBlocks.back();
+        const size_t blockSize = block.size();
+        U64 delta = edges[i] - mLastEdge;
+
+        for ( ; delta >= 0x80; delta >>= 7 )
+        {
+            block.push_back( static_cast<U8>( delta | 0x80 ) );
+        }
+
+        block.push_back( static_cast<U8>( delta ) );
+        mByteSize += block.size() - blockSize;
+        mLastEdge = edges[i];
+        ++mEdgeCount;
+    }
+
+    return count;
+}
+
+EdgeCache::Reader::Reader( const EdgeCache& cache ) :
+    mCache( &cache ),
+    mRemaining( cache.mEdgeCount ),
+    mNextEdge( cache.mStartSample )
+{
+    if ( mRemaining > 0 )
+    {
+        DecodeNext();
+    }
+}
+
+void EdgeCache::Reader::Next()
+{
+    assert( mRemaining > 0 );
+
+    if ( --mRemaining > 0 )
+    {
+        DecodeNext();
+    }
+}
+
+void EdgeCache::Reader::DecodeNext()
+{
+    if ( mOffset == mCache->mBlocks[mBlock].size() )
+    {
+        ++mBlock;
+        mOffset = 0;
+    }
+
+    const U8* bytes = mCache->mBlocks[mBlock].data();
+    U64 delta = 0;
+    U32 shift = 0;
+    U8 byte;
+
+    do
+    {
+        byte = bytes[mOffset++];
+        delta |= static_cast<U64>( byte & 0x7f ) << shift;
+        shift += 7;
+    }
+    while ( byte & 0x80 );
+
+    mNextEdge += delta;
+}
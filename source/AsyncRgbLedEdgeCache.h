@@ -0,0 +1,108 @@
+#ifndef ASYNCRGBLED_EDGE_CACHE
+#define ASYNCRGBLED_EDGE_CACHE
+
+#include <AnalyzerTypes.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief EdgeCache - the sample numbers of every edge read from a channel,
+ * stored as the difference from the previous edge in a variable-length
+ * encoding of seven bits per byte. LED bits are a few hundred samples long
+ * at most, so nearly every edge takes one or two bytes.
+ *
+ * The bytes are kept in fixed-size blocks, so growing the cache never
+ * copies what is stored already. Once maxBytes are stored, further edges
+ * are left out, and the cache only holds the start of the capture.
+ */
+class EdgeCache
+{
+    public:
+        static const size_t DEFAULT_MAX_BYTES = size_t( 64 ) << 20;
+
+        explicit EdgeCache( size_t maxBytes = DEFAULT_MAX_BYTES );
+
+        /// discard all edges, freeing their memory; the first edge added is
+        /// stored relative to startSample
+        void Clear( U64 startSample );
+
+        /**
+         * @brief Append - store count edges, each after the one before.
+         * Returns the number stored, which is less than count once the cache
+         * is full.
+         */
+        size_t Append( const U64* edges, size_t count );
+
+        size_t MaxBytes() const
+        {
+            return mMaxBytes;
+        }
+
+        U64 StartSample() const
+        {
+            return mStartSample;
+        }
+
+        U64 EdgeCount() const
+        {
+            return mEdgeCount;
+        }
+
+        /// the last edge stored, or the start sample if there are none
+        U64 LastEdge() const
+        {
+            return mLastEdge;
+        }
+
+        size_t ByteSize() const
+        {
+            return mByteSize;
+        }
+
+        bool IsFull() const
+        {
+            return mIsFull;
+        }
+
+        /// reads the edges stored when it was created, in order
+        class Reader
+        {
+            public:
+                Reader() = default;
+                explicit Reader( const EdgeCache& cache );
+
+                bool HasNext() const
+                {
+                    return mRemaining > 0;
+                }
+
+                /// the next edge, only valid if HasNext()
+                U64 Peek() const
+                {
+                    return mNextEdge;
+                }
+
+                void Next();
+
+            private:
+                void DecodeNext();
+
+                const EdgeCache* mCache = nullptr;
+                size_t mBlock = 0;
+                size_t mOffset = 0;
+                U64 mRemaining = 0;
+                U64 mNextEdge = 0;
+        };
+
+    private:
+        size_t mMaxBytes;
+        std::vector<std::vector<U8>> mBlocks;
+        size_t mByteSize = 0;
+        U64 mEdgeCount = 0;
+        U64 mStartSample = 0;
+        U64 mLastEdge = 0;
+        bool mIsFull = false;
+};
+
+#endif // of #define ASYNCRGBLED_EDGE_CACHE
@@ -0,0 +1,167 @@
+#include "AsyncRgbLedExport.h"
+
+#include <algorithm> // for std::min/max()
+#include <cassert>
+#include <ostream>
+
+namespace
+{
+    // room for the longest single value the Append functions produce
+    const size_t MINIMUM_CAPACITY = 64;
+
+    const char HEX_DIGITS_UPPER[] = "0123456789ABCDEF";
+    const char HEX_DIGITS_LOWER[] = "0123456789abcdef";
+
+    // two lower-case hex digits for every byte value, for CSS colors
+    struct HexPairTable
+    {
+        char mPairs[256][2];
+
+        HexPairTable()
+        {
+            for ( int i = 0; i < 256; ++i )
+            {
+                mPairs[i][0] = HEX_DIGITS_LOWER[i >> 4];
+                mPairs[i][1] = HEX_DIGITS_LOWER[i & 0xf];
+            }
+        }
+    };
+
+    const HexPairTable HEX_PAIRS;
+
+    // write the decimal digits of value backwards from end, returns the start
+    char* FormatDecimalReversed( U64 value, char* end )
+    {
+        do
+        {
+            *--end = static_cast<char>( '0' + ( value % 10 ) );
+            value /= 10;
+        }
+        while ( value != 0 );
+
+        return end;
+    }
+}
+
+ExportBuffer::ExportBuffer( std::ostream& out, size_t capacity ) :
+    mOut( out ),
+    mBuffer( std::max( capacity, MINIMUM_CAPACITY ) )
+{
+}
+
+ExportBuffer::~ExportBuffer()
+{
+    Flush();
+}
+
+void ExportBuffer::Append( const char* text, size_t length )
+{
+    while ( length > 0 )
+    {
+        Reserve( 1 );
+        const size_t chunk = std::min( length, mBuffer.size() - mUsed );
+        std::memcpy( mBuffer.data() + mUsed, text, chunk );
+        mUsed += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+void ExportBuffer::AppendDecimal( U64 value )
+{
+    char digits[20];
+    char* const end = digits + sizeof( digits );
+    const char* start = FormatDecimalReversed( value, end );
+    Append( start, static_cast<size_t>( end - start ) );
+}
+
+void ExportBuffer::AppendHex( U64 value, U32 bitSize )
+{
+    const U32 digitCount = std::max<U32>( 1, std::min<U32>( ( bitSize + 3 ) / 4, 16 ) );
+    Reserve( digitCount + 2 );
+
+    char* out = mBuffer.data() + mUsed;
+    *out++ = '0';
+    *out++ = 'x';
+
+    for ( U32 d = digitCount; d > 0; --d )
+    {
+        *out++ = HEX_DIGITS_UPPER[( value >> ( ( d - 1 ) * 4 ) ) & 0xf];
+    }
+
+    mUsed += digitCount + 2;
+}
+
+void ExportBuffer::AppendTime( U64 sample, U64 triggerSample, U32 sampleRateHz )
+{
+    assert( sampleRateHz > 0 );
+    const bool isNegative = sample < triggerSample;
+    const U64 offset = isNegative ? ( triggerSample - sample ) : ( sample - triggerSample );
+
+    // remainder < rate < 2^32, so scaling it to nanoseconds fits in a U64
+    U64 seconds = offset / sampleRateHz;
+    const U64 remainder = offset % sampleRateHz;
+    U64 nanoseconds = ( remainder * 1000000000ULL + sampleRateHz / 2 ) / sampleRateHz;
+
+    if ( nanoseconds == 1000000000ULL )
+    {
+        ++seconds;
+        nanoseconds = 0;
+    }
+
+    if ( isNegative )
+    {
+        Append( '-' );
+    }
+
+    AppendDecimal( seconds );
+    Reserve( 10 );
+
+    char* out = mBuffer.data() + mUsed;
+    out[0] = '.';
+
+    for ( int d = 9; d > 0; --d )
+    {
+        out[d] = static_cast<char>( '0' + ( nanoseconds % 10 ) );
+        nanoseconds /= 10;
+    }
+
+    mUsed += 10;
+}
+
+void ExportBuffer::AppendWebColor( const U8* rgb )
+{
+    Reserve( 7 );
+    char* out = mBuffer.data() + mUsed;
+    out[0] = '#';
+
+    for ( int c = 0; c < 3; ++c )
+    {
+        out[1 + c * 2] = HEX_PAIRS.mPairs[rgb[c]][0];
+        out[2 + c * 2] = HEX_PAIRS.mPairs[rgb[c]][1];
+    }
+
+    mUsed += 7;
+}
+
+void FormatWebColor( const U8* rgb, char* buf )
+{
+    buf[0] = '#';
+
+    for ( int c = 0; c < 3; ++c )
+    {
+        buf[1 + c * 2] = HEX_PAIRS.mPairs[rgb[c]][0];
+        buf[2 + c * 2] = HEX_PAIRS.mPairs[rgb[c]][1];
+    }
+
+    buf[7] = '\0';
+}
+
+void ExportBuffer::Flush()
+{
+    if ( mUsed > 0 )
+    {
+        mOut.write( mBuffer.data(), static_cast<std::streamsize>( mUsed ) );
+        mUsed = 0;
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef ASYNCRGBLED_EXPORT
+#define ASYNCRGBLED_EXPORT
+
+#include <AnalyzerTypes.h>
+
+#include <cstring>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * @brief ExportBuffer - accumulates export text in a large buffer and writes
+ * it to the stream in big blocks. Numbers, times and colors are formatted
+ * directly into the buffer, without going through printf or iostreams.
+ */
+class ExportBuffer
+{
+    public:
+        explicit ExportBuffer( std::ostream& out, size_t capacity = 1 << 20 );
+        ~ExportBuffer();
+
+        ExportBuffer( const ExportBuffer& ) = delete;
+        ExportBuffer& operator=( const ExportBuffer& ) = delete;
+
+        void Append( char c )
+        {
+            Reserve( 1 );
+            mBuffer[mUsed++] = c;
+        }
+
+        void Append( const char* text, size_t length );
+
+        void Append( const char* text )
+        {
+            Append( text, std::strlen( text ) );
+        }
+
+        void AppendDecimal( U64 value );
+
+        /// hexadecimal with a 0x prefix, zero-padded to the bit size
+        void AppendHex( U64 value, U32 bitSize );
+
+        /// seconds relative to the trigger, with nanosecond resolution
+        void AppendTime( U64 sample, U64 triggerSample, U32 sampleRateHz );
+
+        /// CSS color of the form #rrggbb
+        void AppendWebColor( const U8* rgb );
+
+        /// raw bytes of a binary export structure
+        template <typename T>
+        void AppendRaw( const T& value )
+        {
+            Append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+        }
+
+        /// write everything buffered so far to the stream
+        void Flush();
+
+    private:
+        void Reserve( size_t length )
+        {
+            if ( mBuffer.size() - mUsed < length )
+            {
+                Flush();
+            }
+        }
+
+        std::ostream& mOut;
+        std::vector<char> mBuffer;
+        size_t mUsed = 0;
+};
+
+/// CSS color of the form #rrggbb, null-terminated, so buf needs 8 characters
+void FormatWebColor( const U8* rgb, char* buf );
+
+/*
+ * Binary export layout. All values are little-endian, and every structure
+ * is naturally aligned, so a reader can map the file and index the records
+ * and packet table directly:
+ *
+ *   BinaryExportHeader
+ *   BinaryExportRecord[mRecordCount]       at mRecordsOffset
+ *   BinaryExportPacket[mPacketCount]       at mPacketTableOffset
+ */
+
+const char BINARY_EXPORT_MAGIC[8] = {'A', 'R', 'G', 'B', 'L', 'E', 'D', '\0'};
+const U32 BINARY_EXPORT_VERSION = 1;
+
+struct BinaryExportHeader
+{
+    char mMagic[8];
+    U32 mVersion;
+    U32 mHeaderSize;
+    U32 mController; // index into the controller table
+    U8 mBitSize;
+    U8 mChannelCount;
+    U16 mReserved;
+    U32 mSampleRateHz;
+    U32 mRecordSize;
+    U64 mTriggerSample;
+    U64 mRecordCount;
+    U64 mRecordsOffset;
+    U64 mPacketCount;
+    U64 mPacketTableOffset;
+};
+
+struct BinaryExportRecord
+{
+    U64 mStartSample;
+    U64 mEndSample;
+    U32 mPacketId;
+    U32 mLedIndex;
+    U16 mRed;
+    U16 mGreen;
+    U16 mBlue;
+    U16 mReserved;
+};
+
+struct BinaryExportPacket
+{
+    U64 mFirstRecord;
+    U32 mPacketId;
+    U32 mRecordCount;
+};
+
+static_assert( sizeof( BinaryExportHeader ) == 72, "binary export header layout changed" );
+static_assert( sizeof( BinaryExportRecord ) == 32, "binary export record layout changed" );
+static_assert( sizeof( BinaryExportPacket ) == 16, "binary export packet layout changed" );
+
+#endif // of #define ASYNCRGBLED_EXPORT
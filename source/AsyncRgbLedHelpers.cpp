@@ -1,6 +1,8 @@
 #include "AsyncRgbLedHelpers.h"
 
+#include <algorithm> // for std::max
 #include <cassert>
+#include <cmath> // for floor, ceil
 #include <cstring> // for memcpy
 #include <iostream>
 
@@ -9,6 +11,135 @@ bool TimingTolerance::WithinTolerance( const double t, const double halfSampleWi
     return ( t >= mMinimumSec - halfSampleWidth ) && ( t <= mMaximumSec + halfSampleWidth );
 }
 
+SampleRange TimingTolerance::ToSampleRange( const double sampleRateHz ) const
+{
+    const double halfSampleWidth = 0.5 / sampleRateHz;
+    const double lowest = std::ceil( ( mMinimumSec - halfSampleWidth ) * sampleRateHz );
+    const double highest = std::floor( ( mMaximumSec + halfSampleWidth ) * sampleRateHz );
+
+    SampleRange result;
+    result.mMinimum = ( lowest > 0.0 ) ? static_cast<U64>( lowest ) : 0;
+    result.mMaximum = ( highest > 0.0 ) ? static_cast<U64>( highest ) : 0;
+
+    // the products above can round differently to the division done when
+    // classifying in seconds; nudge the limits so both forms agree exactly
+    while ( ( result.mMinimum > 0 ) && WithinTolerance( ( result.mMinimum - 1 ) / sampleRateHz, halfSampleWidth ) )
+    {
+        --result.mMinimum;
+    }
+
+    while ( ( result.mMinimum <= result.mMaximum ) && !WithinTolerance( result.mMinimum / sampleRateHz, halfSampleWidth ) )
+    {
+        ++result.mMinimum;
+    }
+
+    while ( WithinTolerance( ( result.mMaximum + 1 ) / sampleRateHz, halfSampleWidth ) )
+    {
+        ++result.mMaximum;
+    }
+
+    while ( ( result.mMaximum > result.mMinimum ) && !WithinTolerance( result.mMaximum / sampleRateHz, halfSampleWidth ) )
+    {
+        --result.mMaximum;
+    }
+
+    return result;
+}
+
+namespace
+{
+    void BuildClassTable( const SampleRange& lowBit, const SampleRange& highBit, std::vector<U8>& table )
+    {
+        table.assign( std::max( lowBit.mMaximum, highBit.mMaximum ) + 1, PULSE_INVALID );
+
+        for ( U64 s = lowBit.mMinimum; s <= lowBit.mMaximum; ++s )
+        {
+            table[s] |= PULSE_BIT_LOW;
+        }
+
+        for ( U64 s = highBit.mMinimum; s <= highBit.mMaximum; ++s )
+        {
+            table[s] |= PULSE_BIT_HIGH;
+        }
+    }
+} // of anonymous namespace
+
+void PulseClassifier::Build( const BitSampleTiming& lowBit, const BitSampleTiming& highBit )
+{
+    BuildClassTable( lowBit.mPositive, highBit.mPositive, mPositive );
+    BuildClassTable( lowBit.mNegative, highBit.mNegative, mNegative );
+}
+
+void CommitPolicy::Configure( U32 maxPendingFrames, U64 maxPendingSamples )
+{
+    mMaxPendingFrames = std::max<U32>( maxPendingFrames, 1 );
+    mMaxPendingSamples = maxPendingSamples;
+}
+
+void CommitPolicy::Start( U64 sample )
+{
+    mPendingFrames = 0;
+    mLastCommitSample = sample;
+}
+
+bool CommitPolicy::AddFrame( U64 sample )
+{
+    ++mPendingFrames;
+    return ( mPendingFrames >= mMaxPendingFrames ) || IsBudgetElapsed( sample );
+}
+
+bool CommitPolicy::EndPacket( U64 sample ) const
+{
+    // an empty packet still commits once the budget is used, so progress
+    // keeps moving through long stretches of undecodable data
+    return ( mPendingFrames > 0 ) || IsBudgetElapsed( sample );
+}
+
+void CommitPolicy::Committed( U64 sample )
+{
+    mPendingFrames = 0;
+    mLastCommitSample = sample;
+}
+
+void LiveLagTracker::Configure( double sampleRateHz, double maxLagSec )
+{
+    mSampleRateHz = sampleRateHz;
+    mMaxLagSec = maxLagSec;
+}
+
+void LiveLagTracker::Start()
+{
+    mIsCaughtUp = false;
+}
+
+void LiveLagTracker::CaughtUp( U64 sample, double seconds )
+{
+    mIsCaughtUp = true;
+    mCaughtUpSample = sample;
+    mCaughtUpSeconds = seconds;
+}
+
+bool LiveLagTracker::IsBehind( U64 sample, double seconds ) const
+{
+    if ( !mIsCaughtUp || ( sample < mCaughtUpSample ) )
+    {
+        return false;
+    }
+
+    const double decodedSec = ( sample - mCaughtUpSample ) / mSampleRateHz;
+    return ( seconds - mCaughtUpSeconds ) - decodedSec > mMaxLagSec;
+}
+
+U64 LiveLagTracker::NewestSample( double seconds ) const
+{
+    if ( !mIsCaughtUp || ( seconds <= mCaughtUpSeconds ) )
+    {
+        return mCaughtUpSample;
+    }
+
+    return mCaughtUpSample + static_cast<U64>( ( seconds - mCaughtUpSeconds ) * mSampleRateHz );
+}
+
 bool BitTiming::WithinTolerance( const double positiveTime,
                                  const double negativeTime,
                                  const double halfSampleWidth) const
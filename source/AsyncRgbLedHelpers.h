@@ -3,6 +3,7 @@
 
 #include <AnalyzerTypes.h>
 #include <iosfwd>
+#include <vector>
 
 enum ColorLayout
 {
@@ -27,6 +28,14 @@ struct RGBValue
 
     static RGBValue CreateFromControllerOrder( ColorLayout layout, U16* values );
 
+    /// as above, with the layout fixed at compile time
+    template <ColorLayout Layout>
+    static RGBValue CreateFromControllerOrder( const U16* values )
+    {
+        return ( Layout == LAYOUT_GRB ) ? RGBValue{values[1], values[0], values[2]} :
+               RGBValue{values[0], values[1], values[2]};
+    }
+
     static RGBValue CreateFromU64( U64 raw );
 
     U64 ConvertToU64() const;
@@ -40,6 +49,99 @@ struct RGBValue
     void ConvertTo8Bit( U8 bitSize, U8* values ) const;
 };
 
+/// bits of Frame::mFlags used by this analyzer. The SDK reserves the top
+/// two bits, for displaying frames as errors or warnings.
+enum FrameFlag
+{
+    /// frame covers a whole packet, with mData1 indexing the LedColorArena
+    /// and the LED index field of mData2 holding the LED count
+    FRAME_FLAG_PACKET = 0x01,
+
+    /// frame covers a run of identical LEDs, from the LED index to the last
+    /// LED index fields of mData2
+    FRAME_FLAG_RUN = 0x02,
+
+    /// LEDs were sent with the high-speed timing of the controller
+    FRAME_FLAG_HIGH_SPEED = 0x04,
+
+    /// the packet ended with a decode error instead of a reset
+    FRAME_FLAG_PACKET_ERROR = 0x08,
+
+    /// packet frame from the timeline scan, with mData1 indexing the
+    /// LazyPacketStore instead of the LedColorArena
+    FRAME_FLAG_LAZY = 0x10
+};
+
+/*
+ * Frame::mData2 layout, so everything about a frame can be read without
+ * asking the host which packet contains it:
+ *   bits 0-19   LED index in the packet (LED count for packet frames)
+ *   bits 20-39  last LED index of a run frame, otherwise zero
+ *   bits 40-63  low 24 bits of the packet sequence number
+ * Frame::mType holds the next 8 bits of the packet sequence number, so it
+ * only wraps after 2^32 packets, like the 32-bit packet ID of the exports.
+ */
+const U32 FRAME_LED_INDEX_BITS = 20;
+const U32 FRAME_PACKET_BITS = 24;
+const U64 FRAME_LED_INDEX_MASK = ( 1ULL << FRAME_LED_INDEX_BITS ) - 1;
+const U64 FRAME_PACKET_MASK = ( 1ULL << FRAME_PACKET_BITS ) - 1;
+
+inline U64 PackFrameData2( U64 packetSequence, U32 ledIndex, U32 lastLedIndex = 0 )
+{
+    return ( ledIndex & FRAME_LED_INDEX_MASK ) |
+           ( ( lastLedIndex & FRAME_LED_INDEX_MASK ) << FRAME_LED_INDEX_BITS ) |
+           ( ( packetSequence & FRAME_PACKET_MASK ) << ( FRAME_LED_INDEX_BITS * 2 ) );
+}
+
+inline U32 FrameLedIndex( U64 data2 )
+{
+    return static_cast<U32>( data2 & FRAME_LED_INDEX_MASK );
+}
+
+inline U32 FrameLastLedIndex( U64 data2 )
+{
+    return static_cast<U32>( ( data2 >> FRAME_LED_INDEX_BITS ) & FRAME_LED_INDEX_MASK );
+}
+
+inline U8 PackFrameType( U64 packetSequence )
+{
+    return static_cast<U8>( packetSequence >> FRAME_PACKET_BITS );
+}
+
+inline U32 FramePacketSequence( U64 data2, U8 type )
+{
+    return static_cast<U32>( data2 >> ( FRAME_LED_INDEX_BITS * 2 ) ) |
+           ( static_cast<U32>( type ) << FRAME_PACKET_BITS );
+}
+
+/**
+ * @brief SampleRange - inclusive range of pulse lengths, in samples. This is
+ * the sample-domain form of a TimingTolerance at one particular sample rate
+ */
+struct SampleRange
+{
+    U64 mMinimum = 0;
+    U64 mMaximum = 0;
+
+    bool Contains( const U64 samples ) const
+    {
+        return ( samples >= mMinimum ) && ( samples <= mMaximum );
+    }
+};
+
+/**
+ * @brief ControllerTraits - the properties of a controller which change the
+ * shape of the decode loop, as compile-time constants. Pulse timing is not
+ * included, since it depends on the sample rate of the capture.
+ */
+template <U8 BitSize, ColorLayout Layout, bool HasHighSpeed>
+struct ControllerTraits
+{
+    static constexpr U8 BIT_SIZE = BitSize;
+    static constexpr ColorLayout LAYOUT = Layout;
+    static constexpr bool HAS_HIGH_SPEED = HasHighSpeed;
+};
+
 struct TimingTolerance
 {
     TimingTolerance() = default;
@@ -53,6 +155,12 @@ struct TimingTolerance
     double mMaximumSec = 0.0;
 
     bool WithinTolerance( const double t, const double halfSampleWidth ) const;
+
+    /**
+     * @brief ToSampleRange - compute the pulse lengths, in samples, which
+     * WithinTolerance accepts at the given sample rate.
+     */
+    SampleRange ToSampleRange( const double sampleRateHz ) const;
 };
 
 struct BitTiming
@@ -71,6 +179,178 @@ struct BitTiming
                           const double halfSampleWidth) const;
 };
 
+struct BitSampleTiming
+{
+    SampleRange mPositive;
+    SampleRange mNegative;
+
+    // nominal low time, used to place the end of a bit followed by a reset
+    U64 mNominalNegative = 0;
+
+    bool Contains( const U64 positiveSamples, const U64 negativeSamples ) const
+    {
+        return mPositive.Contains( positiveSamples ) && mNegative.Contains( negativeSamples );
+    }
+};
+
+/// classification of a single pulse length: a bit-mask of the data bit
+/// values which the pulse is consistent with
+enum PulseClass
+{
+    PULSE_INVALID = 0,
+    PULSE_BIT_LOW = 1 << BIT_LOW,
+    PULSE_BIT_HIGH = 1 << BIT_HIGH,
+    PULSE_AMBIGUOUS = PULSE_BIT_LOW | PULSE_BIT_HIGH
+};
+
+inline U8 PulseClassFor( BitState value )
+{
+    return static_cast<U8>( 1 << value );
+}
+
+/// a pulse length in samples, saturated to fit in 32 bits
+inline U32 ClampToU32( U64 samples )
+{
+    return static_cast<U32>( ( samples < 0xFFFFFFFFULL ) ? samples : 0xFFFFFFFFULL );
+}
+
+/**
+ * @brief PulseClassifier - lookup tables mapping the length of a high or low
+ * pulse, in samples, to a PulseClass, for one speed mode of a controller.
+ * Each table stops at the longest legal pulse; anything longer is invalid.
+ */
+struct PulseClassifier
+{
+    std::vector<U8> mPositive;
+    std::vector<U8> mNegative;
+
+    void Build( const BitSampleTiming& lowBit, const BitSampleTiming& highBit );
+
+    U8 ClassifyPositive( const U64 samples ) const
+    {
+        return ( samples < mPositive.size() ) ? mPositive[samples] : static_cast<U8>( PULSE_INVALID );
+    }
+
+    U8 ClassifyNegative( const U64 samples ) const
+    {
+        return ( samples < mNegative.size() ) ? mNegative[samples] : static_cast<U8>( PULSE_INVALID );
+    }
+};
+
+/**
+ * @brief DecoderTiming - all the timing data for one controller, converted
+ * to sample counts at the capture sample rate. This is computed once per
+ * analysis run, so classifying a bit only requires integer comparisons.
+ */
+struct DecoderTiming
+{
+    // indexed by [isHighSpeed][BitState]
+    BitSampleTiming mDataTiming[2][2];
+    bool mHasHighSpeed = false;
+
+    // indexed by [isHighSpeed]
+    PulseClassifier mClassifier[2];
+
+    // a low pulse of this many samples or fewer can't be part of a data bit,
+    // in either speed mode supported by the controller
+    U32 mTooShortLowSamples = 0;
+
+    // a low pulse longer than this is a reset, when reading data
+    U32 mResetSamples = 0;
+
+    // a low pulse longer than this is a reset, when synchronising
+    U64 mSyncResetSamples = 0;
+
+    const BitSampleTiming& DataTiming( BitState value, bool isHighSpeed ) const
+    {
+        return mDataTiming[isHighSpeed ? 1 : 0][value];
+    }
+
+    const PulseClassifier& Classifier( bool isHighSpeed ) const
+    {
+        return mClassifier[isHighSpeed ? 1 : 0];
+    }
+};
+
+/**
+ * @brief CommitPolicy - decides when decoded frames are committed to the
+ * results: once enough frames are pending, once enough capture time has
+ * passed since the last commit, or at the end of a packet with frames pending.
+ */
+class CommitPolicy
+{
+    public:
+        void Configure( U32 maxPendingFrames, U64 maxPendingSamples );
+
+        /// forget any pending frames, and measure time from this sample
+        void Start( U64 sample );
+
+        /// record a frame ending at sample, returns true if a commit is due
+        bool AddFrame( U64 sample );
+
+        /// returns true if a commit is due at the end of a packet
+        bool EndPacket( U64 sample ) const;
+
+        void Committed( U64 sample );
+
+        /// returns true once the time budget since the last commit is used
+        bool IsIntervalElapsed( U64 sample ) const
+        {
+            return IsBudgetElapsed( sample );
+        }
+
+        U32 PendingFrames() const
+        {
+            return mPendingFrames;
+        }
+
+    private:
+        bool IsBudgetElapsed( U64 sample ) const
+        {
+            // the last frame of a packet ends at its nominal end, which can
+            // be later than the sample the packet end is reported at
+            return ( sample >= mLastCommitSample ) &&
+                   ( ( sample - mLastCommitSample ) >= mMaxPendingSamples );
+        }
+
+        U32 mMaxPendingFrames = 1;
+        U64 mMaxPendingSamples = 0;
+        U32 mPendingFrames = 0;
+        U64 mLastCommitSample = 0;
+};
+
+/**
+ * @brief LiveLagTracker - estimates how far decoding is behind the newest
+ * sample of a live capture. Whenever decoding has used up the capture so
+ * far, and waited for more, it is caught up; from then on the capture is
+ * assumed to grow in real time, so decoding falls behind when it covers
+ * less signal time than the wall-clock time which has passed.
+ */
+class LiveLagTracker
+{
+    public:
+        void Configure( double sampleRateHz, double maxLagSec );
+
+        /// forget when decoding was last caught up
+        void Start();
+
+        /// decoding reached the newest sample of the capture at time seconds
+        void CaughtUp( U64 sample, double seconds );
+
+        /// returns true if decoding at sample is more than the maximum lag behind
+        bool IsBehind( U64 sample, double seconds ) const;
+
+        /// the sample the capture has probably reached at time seconds
+        U64 NewestSample( double seconds ) const;
+
+    private:
+        double mSampleRateHz = 1.0;
+        double mMaxLagSec = 0.0;
+        bool mIsCaughtUp = false;
+        U64 mCaughtUpSample = 0;
+        double mCaughtUpSeconds = 0.0;
+};
+
 std::ostream& operator<<(std::ostream& out, const TimingTolerance& tol);
 std::ostream& operator<<(std::ostream& out, const BitTiming& tol);
 
@@ -0,0 +1,423 @@
+#include "AsyncRgbLedLazyDecode.h"
+
+#include <algorithm> // for std::min(), std::copy
+#include <cassert>
+
+namespace
+{
+    /// the value of one bit, following the same checks as the analyzer's ReadBit
+    bool ClassifyBit( const DecoderTiming& timing, bool isHighSpeed, U32 highSamples, U32 lowSamples,
+                      bool isResetBit, BitState& value )
+    {
+        const PulseClassifier& classifier = timing.Classifier( isHighSpeed );
+        const U8 positiveClass = classifier.ClassifyPositive( highSamples );
+
+        if ( positiveClass & PULSE_BIT_LOW )
+        {
+            value = BIT_LOW;
+        }
+        else if ( positiveClass & PULSE_BIT_HIGH )
+        {
+            value = BIT_HIGH;
+        }
+        else
+        {
+            return false;
+        }
+
+        if ( isResetBit )
+        {
+            // the low time is the reset, which no data bit matches
+            return true;
+        }
+
+        return ( lowSamples > timing.mTooShortLowSamples ) &&
+               ( classifier.ClassifyNegative( lowSamples ) & PulseClassFor( value ) );
+    }
+
+    U32 CopyColors( const std::vector<RGBValue>& decoded, U32 firstLed, U32 count, RGBValue* colors )
+    {
+        if ( firstLed >= decoded.size() )
+        {
+            return 0;
+        }
+
+        const U32 available = std::min( count, static_cast<U32>( decoded.size() ) - firstLed );
+        std::copy( decoded.begin() + firstLed, decoded.begin() + firstLed + available, colors );
+        return available;
+    }
+}
+
+bool DecodePacketPulses( const DecoderTiming& timing, U8 bitSize, ColorLayout layout,
+                         const U32* pulses, size_t pulseCount,
+                         std::vector<RGBValue>& colors, bool& isHighSpeed )
+{
+    colors.clear();
+    isHighSpeed = false;
+
+    const size_t bitCount = pulseCount / 2;
+    const size_t ledBits = 3 * bitSize;
+    U16 channels[3] = {0, 0, 0};
+
+    for ( size_t bit = 0; bit < bitCount; ++bit )
+    {
+        const U32 highSamples = pulses[2 * bit];
+        const U32 lowSamples = pulses[2 * bit + 1];
+        const bool isResetBit = ( bit + 1 == bitCount );
+        BitState value = BIT_LOW;
+
+        if ( bit == 0 )
+        {
+            // the speed mode is detected from both pulses of the first bit,
+            // so a packet of a single bit can't be decoded
+            bool isDetected = false;
+
+            for ( const bool isHighSpeedMode : {false, true} )
+            {
+                if ( isResetBit || ( isHighSpeedMode && !timing.mHasHighSpeed ) )
+                {
+                    break;
+                }
+
+                const PulseClassifier& classifier = timing.Classifier( isHighSpeedMode );
+                const U8 matches = classifier.ClassifyPositive( highSamples ) & classifier.ClassifyNegative( lowSamples );
+
+                if ( matches != PULSE_INVALID )
+                {
+                    isHighSpeed = isHighSpeedMode;
+                    value = ( matches & PULSE_BIT_LOW ) ? BIT_LOW : BIT_HIGH;
+                    isDetected = true;
+                    break;
+                }
+            }
+
+            if ( !isDetected )
+            {
+                return false;
+            }
+        }
+        else if ( !ClassifyBit( timing, isHighSpeed, highSamples, lowSamples, isResetBit, value ) )
+        {
+            return false;
+        }
+
+        // channel values are sent MSB first
+        const size_t ledBit = bit % ledBits;
+        U16& channel = channels[ledBit / bitSize];
+        channel = static_cast<U16>( ( channel << 1 ) | value );
+
+        if ( ledBit + 1 == ledBits )
+        {
+            colors.push_back( RGBValue::CreateFromControllerOrder( layout, channels ) );
+            channels[0] = channels[1] = channels[2] = 0;
+        }
+    }
+
+    return true;
+}
+
+LazyPacketStore::LazyPacketStore( size_t blockBytes ) :
+    mBlockBytes( blockBytes )
+{
+}
+
+LazyPacketStore::~LazyPacketStore()
+{
+    StopBackgroundDecode();
+}
+
+void LazyPacketStore::Clear( const DecoderTiming& timing, U8 bitSize, ColorLayout layout, U32 maxPacketLeds )
+{
+    StopBackgroundDecode();
+
+    std::lock_guard<std::mutex> lock( mMutex );
+    assert( bitSize > 0 && bitSize <= 16 );
+    mTiming = timing;
+    mBitSize = bitSize;
+    mLayout = layout;
+    mMaxPacketPulses = PulsesPerLed() * maxPacketLeds;
+    std::vector<std::vector<U8>>().swap( mPulseBlocks );
+    mFreedBlocks = 0;
+    mByteCount = 0;
+    mPacketOffsets.clear();
+    mOpenOffset = 0;
+    mOpenPulseCount = 0;
+    mIsOpenTruncated = false;
+    mDecoded.clear();
+    mIsDecodedValid = false;
+    mBackgroundColors.Clear( bitSize );
+    mBackgroundCount = 0;
+}
+
+void LazyPacketStore::AppendPulses( const U32* pulses, size_t count )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if ( mOpenPulseCount + count > mMaxPacketPulses )
+    {
+        mIsOpenTruncated = true;
+        count = mMaxPacketPulses - mOpenPulseCount;
+    }
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        U32 pulse = pulses[i];
+
+        // an encoded pulse may continue in the next block
+        for ( bool isLastByte = false; !isLastByte; pulse >>= 7 )
+        {
+            if ( mByteCount == mPulseBlocks.size() * mBlockBytes )
+            {
+                mPulseBlocks.emplace_back();
+                mPulseBlocks.back().reserve( mBlockBytes );
+            }
+
+            isLastByte = ( pulse < 0x80 );
+            mPulseBlocks.back().push_back( static_cast<U8>( isLastByte ? pulse : ( pulse | 0x80 ) ) );
+            ++mByteCount;
+        }
+    }
+
+    mOpenPulseCount += count;
+}
+
+U32 LazyPacketStore::OpenPacketLedCount() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return static_cast<U32>( mOpenPulseCount / PulsesPerLed() );
+}
+
+bool LazyPacketStore::IsOpenPacketTruncated() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mIsOpenTruncated;
+}
+
+U64 LazyPacketStore::EndPacket()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mPacketOffsets.push_back( mOpenOffset );
+    mOpenOffset = mByteCount;
+    mOpenPulseCount = 0;
+    mIsOpenTruncated = false;
+    mBackgroundWakeup.notify_one();
+    return mPacketOffsets.size() - 1;
+}
+
+void LazyPacketStore::DiscardPacket()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    // the pulses of the packet being recorded are never freed
+    const size_t blockCount = ( mOpenOffset + mBlockBytes - 1 ) / mBlockBytes;
+    mByteCount = mOpenOffset;
+    mPulseBlocks.resize( std::max( blockCount, mFreedBlocks ) );
+
+    if ( blockCount > mFreedBlocks )
+    {
+        mPulseBlocks.back().resize( mByteCount - ( blockCount - 1 ) * mBlockBytes );
+    }
+
+    mOpenPulseCount = 0;
+    mIsOpenTruncated = false;
+}
+
+U64 LazyPacketStore::PacketCount() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mPacketOffsets.size();
+}
+
+U64 LazyPacketStore::StoredBytes() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mByteCount - mFreedBlocks * mBlockBytes;
+}
+
+void LazyPacketStore::StartBackgroundDecode()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if ( !mBackgroundThread.joinable() )
+    {
+        mBackgroundThread = std::thread( &LazyPacketStore::BackgroundDecode, this );
+    }
+}
+
+U64 LazyPacketStore::BackgroundDecodedCount() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mBackgroundCount;
+}
+
+U32 LazyPacketStore::GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors ) const
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    if ( packet >= mPacketOffsets.size() )
+    {
+        return 0;
+    }
+
+    if ( packet < mBackgroundCount )
+    {
+        // the arena has its own lock
+        lock.unlock();
+        return mBackgroundColors.GetColors( packet, firstLed, count, colors );
+    }
+
+    DecodePacket( packet );
+    return CopyColors( mDecoded, firstLed, count, colors );
+}
+
+LazyPacketStore::Reader::Reader( const LazyPacketStore& store ) :
+    mStore( &store ),
+    mBackgroundReader( store.mBackgroundColors )
+{
+}
+
+U32 LazyPacketStore::Reader::GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors )
+{
+    if ( !mIsDecodedValid || ( mDecodedPacket != packet ) )
+    {
+        std::unique_lock<std::mutex> lock( mStore->mMutex );
+
+        if ( packet >= mStore->mPacketOffsets.size() )
+        {
+            return 0;
+        }
+
+        if ( packet < mStore->mBackgroundCount )
+        {
+            lock.unlock();
+            return mBackgroundReader.GetColors( packet, firstLed, count, colors );
+        }
+
+        // stored pulses never change, and the timing only changes in Clear()
+        mStore->ReadPulses( packet, mPulses );
+        lock.unlock();
+
+        bool isHighSpeed = false;
+        DecodePacketPulses( mStore->mTiming, mStore->mBitSize, mStore->mLayout, mPulses.data(), mPulses.size(),
+                            mDecoded, isHighSpeed );
+        mDecodedPacket = packet;
+        mIsDecodedValid = true;
+    }
+
+    return CopyColors( mDecoded, firstLed, count, colors );
+}
+
+void LazyPacketStore::DecodePacket( U64 packet ) const
+{
+    if ( mIsDecodedValid && ( mDecodedPacket == packet ) )
+    {
+        return;
+    }
+
+    ReadPulses( packet, mPulses );
+    bool isHighSpeed = false;
+
+    // an invalid bit leaves the LEDs before it
+    DecodePacketPulses( mTiming, mBitSize, mLayout, mPulses.data(), mPulses.size(), mDecoded, isHighSpeed );
+    mDecodedPacket = packet;
+    mIsDecodedValid = true;
+}
+
+void LazyPacketStore::ReadPulses( U64 packet, std::vector<U32>& pulses ) const
+{
+    // the packet being recorded follows the last stored packet
+    const size_t end = ( packet + 1 < mPacketOffsets.size() ) ? mPacketOffsets[packet + 1] : mOpenOffset;
+    const size_t begin = mPacketOffsets[packet];
+    pulses.clear();
+
+    size_t block = begin / mBlockBytes;
+    size_t blockOffset = begin % mBlockBytes;
+    U32 pulse = 0;
+    U32 shift = 0;
+
+    for ( size_t offset = begin; offset < end; ++offset )
+    {
+        if ( blockOffset == mBlockBytes )
+        {
+            ++block;
+            blockOffset = 0;
+        }
+
+        assert( block >= mFreedBlocks );
+        const U8 byte = mPulseBlocks[block][blockOffset++];
+        pulse |= static_cast<U32>( byte & 0x7f ) << shift;
+        shift += 7;
+
+        if ( !( byte & 0x80 ) )
+        {
+            pulses.push_back( pulse );
+            pulse = 0;
+            shift = 0;
+        }
+    }
+}
+
+void LazyPacketStore::FreeDecodedBlocks()
+{
+    // pulses before the first packet not decoded yet are only needed again
+    // after Clear() starts over
+    const size_t keepOffset = ( mBackgroundCount < mPacketOffsets.size() ) ? mPacketOffsets[mBackgroundCount] : mOpenOffset;
+
+    for ( ; ( mFreedBlocks + 1 ) * mBlockBytes <= keepOffset; ++mFreedBlocks )
+    {
+        std::vector<U8>().swap( mPulseBlocks[mFreedBlocks] );
+    }
+}
+
+void LazyPacketStore::StopBackgroundDecode()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mIsStopping = true;
+    }
+
+    mBackgroundWakeup.notify_all();
+
+    if ( mBackgroundThread.joinable() )
+    {
+        mBackgroundThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock( mMutex );
+    mIsStopping = false;
+}
+
+void LazyPacketStore::BackgroundDecode()
+{
+    std::vector<U32> pulses;
+    std::vector<RGBValue> colors;
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    for ( ; ; )
+    {
+        mBackgroundWakeup.wait( lock, [this]()
+        {
+            return mIsStopping || ( mBackgroundCount < mPacketOffsets.size() );
+        } );
+
+        if ( mIsStopping )
+        {
+            return;
+        }
+
+        // only the pulses are read under the lock, so decoding doesn't hold
+        // up the analysis or the UI. The timing only changes in Clear(),
+        // which stops this thread first.
+        const U64 packet = mBackgroundCount;
+        ReadPulses( packet, pulses );
+        lock.unlock();
+
+        bool isHighSpeed = false;
+        DecodePacketPulses( mTiming, mBitSize, mLayout, pulses.data(), pulses.size(), colors, isHighSpeed );
+        mBackgroundColors.AddPacket( colors.data(), static_cast<U32>( colors.size() ) );
+        assert( mBackgroundColors.PacketCount() == packet + 1 );
+
+        lock.lock();
+        ++mBackgroundCount;
+        FreeDecodedBlocks();
+    }
+}
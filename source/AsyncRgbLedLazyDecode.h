@@ -0,0 +1,173 @@
+#ifndef ASYNCRGBLED_LAZY_DECODE
+#define ASYNCRGBLED_LAZY_DECODE
+
+#include <AnalyzerTypes.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncRgbLedHelpers.h"
+#include "AsyncRgbLedColorArena.h"
+
+/**
+ * @brief DecodePacketPulses - decode the LEDs of one packet from its pulse
+ * lengths in samples, alternating high and low and starting with the first
+ * high pulse after a reset. The final low pulse is the reset ending the
+ * packet, so only its high pulse is checked.
+ *
+ * The speed mode is detected from the first bit, as when decoding a
+ * capture. Decoding stops at the first invalid bit, and colors receives
+ * only the complete LEDs before it. Returns false if an invalid bit was found.
+ */
+bool DecodePacketPulses( const DecoderTiming& timing, U8 bitSize, ColorLayout layout,
+                         const U32* pulses, size_t pulseCount,
+                         std::vector<RGBValue>& colors, bool& isHighSpeed );
+
+/**
+ * @brief LazyPacketStore - the pulse lengths of every packet, recorded by
+ * the timeline scan without decoding them. LED colors are decoded from the
+ * pulses when a packet is first shown or exported.
+ *
+ * Pulses are stored in a variable-length encoding of seven bits per byte,
+ * so the pulses of a bit take two to four bytes at common sample rates.
+ * The bytes are kept in fixed-size blocks, so growing the store never
+ * copies what is stored already. A packet is recorded as it arrives, up to
+ * maxPacketLeds LEDs; pulses after that are dropped.
+ *
+ * Once started, a background thread decodes the stored packets in order,
+ * keeping their colors in a LedColorArena, so reading a packet it has
+ * reached doesn't decode anything. The pulses of the packets it has
+ * decoded are freed a block at a time.
+ *
+ * The analysis thread appends packets while the UI thread reads them back,
+ * so all access is serialised by a mutex.
+ */
+class LazyPacketStore
+{
+    public:
+        static const size_t DEFAULT_BLOCK_BYTES = 1 << 20;
+
+        explicit LazyPacketStore( size_t blockBytes = DEFAULT_BLOCK_BYTES );
+        ~LazyPacketStore();
+
+        /// the most LEDs a packet frame can count
+        static const U32 MAX_PACKET_LEDS = static_cast<U32>( FRAME_LED_INDEX_MASK );
+
+        /// discard all packets, stopping the background decoding, and set
+        /// the timing used to decode new ones
+        void Clear( const DecoderTiming& timing, U8 bitSize, ColorLayout layout,
+                    U32 maxPacketLeds = MAX_PACKET_LEDS );
+
+        /// add pulses to the packet being recorded
+        void AppendPulses( const U32* pulses, size_t count );
+
+        /// number of complete LEDs the pulses of the packet being recorded could hold
+        U32 OpenPacketLedCount() const;
+
+        /// returns true if pulses of the packet being recorded were dropped
+        bool IsOpenPacketTruncated() const;
+
+        /// store the packet being recorded, returns the index of the packet
+        U64 EndPacket();
+
+        /// drop the packet being recorded
+        void DiscardPacket();
+
+        U64 PacketCount() const;
+
+        /// size of the encoded pulses still held, in bytes
+        U64 StoredBytes() const;
+
+        /// decode every packet stored, now and later, on a background thread
+        void StartBackgroundDecode();
+
+        /// number of packets decoded by the background thread
+        U64 BackgroundDecodedCount() const;
+
+        /**
+         * @brief GetColors - decode count colors of a packet, starting at LED
+         * firstLed. Returns the number of colors decoded, which is less than
+         * count if the packet ends, or has an invalid bit, first.
+         */
+        U32 GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors ) const;
+
+        /**
+         * @brief Reader - reads packets with its own decoded packet, so
+         * readers on different threads don't evict each other's. Packets are
+         * decoded without the store's lock, and reading more of the last
+         * packet doesn't take it at all. A reader is only valid until the
+         * store is cleared.
+         */
+        class Reader
+        {
+            public:
+                explicit Reader( const LazyPacketStore& store );
+
+                /// as LazyPacketStore::GetColors
+                U32 GetColors( U64 packet, U32 firstLed, U32 count, RGBValue* colors );
+
+            private:
+                const LazyPacketStore* mStore;
+                LedColorArena::Reader mBackgroundReader;
+                std::vector<U32> mPulses;
+                std::vector<RGBValue> mDecoded;
+                U64 mDecodedPacket = 0;
+                bool mIsDecodedValid = false;
+        };
+
+    private:
+        size_t PulsesPerLed() const
+        {
+            return 2 * 3 * static_cast<size_t>( mBitSize );
+        }
+
+        void DecodePacket( U64 packet ) const;
+
+        /// expand the pulses of a packet into pulses
+        void ReadPulses( U64 packet, std::vector<U32>& pulses ) const;
+
+        /// free the blocks holding only pulses of packets decoded in the background
+        void FreeDecodedBlocks();
+
+        void StopBackgroundDecode();
+        void BackgroundDecode();
+
+        mutable std::mutex mMutex;
+        DecoderTiming mTiming;
+        U8 mBitSize = 8;
+        ColorLayout mLayout = LAYOUT_RGB;
+        size_t mMaxPacketPulses = 0;
+
+        // encoded pulses of all packets and then of the packet being
+        // recorded, and the offset of each stored packet's first byte. The
+        // first mFreedBlocks blocks have been freed.
+        size_t mBlockBytes;
+        std::vector<std::vector<U8>> mPulseBlocks;
+        size_t mFreedBlocks = 0;
+        size_t mByteCount = 0;
+        std::vector<size_t> mPacketOffsets;
+        size_t mOpenOffset = 0;
+        size_t mOpenPulseCount = 0;
+        bool mIsOpenTruncated = false;
+
+        // pulses of the packet being decoded
+        mutable std::vector<U32> mPulses;
+
+        // colors of the packets decoded in the background, which is the
+        // first mBackgroundCount packets
+        std::thread mBackgroundThread;
+        std::condition_variable mBackgroundWakeup;
+        bool mIsStopping = false;
+        LedColorArena mBackgroundColors;
+        U64 mBackgroundCount = 0;
+
+        // colors of the last packet decoded, so reading one packet in
+        // blocks only decodes it once
+        mutable std::vector<RGBValue> mDecoded;
+        mutable U64 mDecodedPacket = 0;
+        mutable bool mIsDecodedValid = false;
+};
+
+#endif // of #define ASYNCRGBLED_LAZY_DECODE
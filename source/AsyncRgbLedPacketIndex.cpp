@@ -0,0 +1,67 @@
+#include "AsyncRgbLedPacketIndex.h"
+
+#include <algorithm> // for std::upper_bound, std::lower_bound
+#include <cassert>
+
+void PacketIndex::Clear()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mEntries.clear();
+}
+
+void PacketIndex::Add( const PacketIndexEntry& entry )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    assert( entry.mStartSample <= entry.mEndSample );
+    assert( mEntries.empty() || ( mEntries.back().mStartSample < entry.mStartSample ) );
+    mEntries.push_back( entry );
+}
+
+U64 PacketIndex::Count() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mEntries.size();
+}
+
+bool PacketIndex::Get( U64 index, PacketIndexEntry& entry ) const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    if ( index >= mEntries.size() )
+    {
+        return false;
+    }
+
+    entry = mEntries[index];
+    return true;
+}
+
+bool PacketIndex::FindPacketAtSample( U64 sample, U64& index ) const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    const auto next = std::upper_bound( mEntries.begin(), mEntries.end(), sample,
+                                        []( U64 s, const PacketIndexEntry & entry )
+    {
+        return s < entry.mStartSample;
+    } );
+
+    if ( next == mEntries.begin() )
+    {
+        return false;
+    }
+
+    index = static_cast<U64>( ( next - mEntries.begin() ) - 1 );
+    return true;
+}
+
+U64 PacketIndex::FirstPacketEndingAfter( U64 sample ) const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    const auto first = std::lower_bound( mEntries.begin(), mEntries.end(), sample,
+                                         []( const PacketIndexEntry & entry, U64 s )
+    {
+        return entry.mEndSample < s;
+    } );
+
+    return static_cast<U64>( first - mEntries.begin() );
+}
@@ -0,0 +1,55 @@
+#ifndef ASYNCRGBLED_PACKET_INDEX
+#define ASYNCRGBLED_PACKET_INDEX
+
+#include <AnalyzerTypes.h>
+
+#include <mutex>
+#include <vector>
+
+/// one decoded packet, as recorded in the PacketIndex
+struct PacketIndexEntry
+{
+    U64 mStartSample;   // first sample of the first LED
+    U64 mEndSample;     // last sample of the last LED
+    U64 mFirstFrame;
+    U32 mFrameCount;
+    U32 mLedCount;
+};
+
+/**
+ * @brief PacketIndex - the start and end of every packet containing LEDs,
+ * in sample order, so a sample position can be mapped to its packet with a
+ * binary search instead of a scan over all the frames.
+ *
+ * The analysis thread appends packets while the UI thread looks them up,
+ * so all access is serialised by a mutex.
+ */
+class PacketIndex
+{
+    public:
+        void Clear();
+
+        /// append a packet, which must start after the previous one
+        void Add( const PacketIndexEntry& entry );
+
+        U64 Count() const;
+
+        bool Get( U64 index, PacketIndexEntry& entry ) const;
+
+        /**
+         * @brief FindPacketAtSample - the last packet starting at or before
+         * sample. The sample may be after the end of that packet, in the
+         * idle time before the next one. Returns false if sample is before
+         * the first packet.
+         */
+        bool FindPacketAtSample( U64 sample, U64& index ) const;
+
+        /// first packet ending at or after sample, or Count() if there is none
+        U64 FirstPacketEndingAfter( U64 sample ) const;
+
+    private:
+        mutable std::mutex mMutex;
+        std::vector<PacketIndexEntry> mEntries;
+};
+
+#endif // of #define ASYNCRGBLED_PACKET_INDEX
@@ -0,0 +1,236 @@
+#include "AsyncRgbLedSegmentDecoder.h"
+
+#include <cassert>
+
+namespace
+{
+    /// collects the packets and LEDs of one segment
+    class SegmentOutput : public DecoderOutput
+    {
+        public:
+            explicit SegmentOutput( DecodedSegment& segment ) :
+                mSegment( segment )
+            {
+            }
+
+            void StartPacket() override
+            {
+                mSegment.mPackets.push_back( DecodedPacket{mSegment.mLeds.size(), 0, false, false, 0} );
+                mIsPacketOpen = true;
+            }
+
+            void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed ) override
+            {
+                mSegment.mLeds.push_back( DecodedLed{beginSample, endSample, rgb} );
+                ++mSegment.mPackets.back().mLedCount;
+                mSegment.mPackets.back().mIsHighSpeed = isHighSpeed;
+            }
+
+            void EndPacket( bool isError, U64 endSample ) override
+            {
+                mSegment.mPackets.back().mIsError = isError;
+                mSegment.mPackets.back().mEndSample = endSample;
+                mIsPacketOpen = false;
+            }
+
+            /// the packet started after the last reset belongs to the next segment
+            void DropOpenPacket()
+            {
+                if ( mIsPacketOpen )
+                {
+                    assert( mSegment.mPackets.back().mLedCount == 0 );
+                    mSegment.mPackets.pop_back();
+                    mIsPacketOpen = false;
+                }
+            }
+
+        private:
+            DecodedSegment& mSegment;
+            bool mIsPacketOpen = false;
+    };
+}
+
+void DecodeSegment( LedDecoder& decoder, const U64* edges, size_t edgeCount, U64 idleSample,
+                    DecodedSegment& segment )
+{
+    assert( edgeCount > 0 );
+    segment.mLeds.clear();
+    segment.mPackets.clear();
+
+    SegmentOutput output( segment );
+    decoder.Start( edges[0], &output );
+    decoder.Push( edges + 1, edgeCount - 1 );
+    decoder.Idle( idleSample );
+    output.DropOpenPacket();
+}
+
+SegmentDecodePool::~SegmentDecodePool()
+{
+    Stop();
+}
+
+void SegmentDecodePool::Start( const DecoderTiming& timing, U8 bitSize, ColorLayout layout, size_t threadCount )
+{
+    Stop();
+    assert( threadCount > 0 );
+    mDecoders.clear();
+
+    for ( size_t i = 0; i < threadCount; ++i )
+    {
+        mDecoders.push_back( LedDecoder::Create( timing, bitSize, layout ) );
+    }
+
+    for ( size_t i = 1; i < threadCount; ++i )
+    {
+        mThreads.emplace_back( &SegmentDecodePool::WorkerThread, this, i );
+    }
+}
+
+void SegmentDecodePool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mIsStopping = true;
+    }
+
+    mBatchReady.notify_all();
+
+    for ( std::thread& thread : mThreads )
+    {
+        thread.join();
+    }
+
+    mThreads.clear();
+    mIsStopping = false;
+}
+
+void SegmentDecodePool::DecodeBatch( const U64* edges, const size_t* offsets, size_t segmentCount, U64 resetSamples,
+                                     DecodedSegment* segments )
+{
+    // a single segment isn't worth waking the workers for
+    const bool isShared = ( segmentCount > 1 ) && !mThreads.empty();
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mEdges = edges;
+        mOffsets = offsets;
+        mSegmentCount = segmentCount;
+        mResetSamples = resetSamples;
+        mSegments = segments;
+        mNextSegment = 0;
+
+        if ( isShared )
+        {
+            mBusyWorkers = mThreads.size();
+            ++mBatchNumber;
+        }
+    }
+
+    if ( isShared )
+    {
+        mBatchReady.notify_all();
+    }
+
+    DecodeSegments( *mDecoders[0] );
+
+    if ( isShared )
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+        mBatchDone.wait( lock, [this]()
+        {
+            return mBusyWorkers == 0;
+        } );
+    }
+}
+
+void SegmentDecodePool::WorkerThread( size_t index )
+{
+    U64 batchNumber = 0;
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    for ( ; ; )
+    {
+        mBatchReady.wait( lock, [this, batchNumber]()
+        {
+            return mIsStopping || ( mBatchNumber != batchNumber );
+        } );
+
+        if ( mIsStopping )
+        {
+            return;
+        }
+
+        batchNumber = mBatchNumber;
+        lock.unlock();
+        DecodeSegments( *mDecoders[index] );
+        lock.lock();
+
+        if ( --mBusyWorkers == 0 )
+        {
+            mBatchDone.notify_one();
+        }
+    }
+}
+
+void SegmentDecodePool::DecodeSegments( LedDecoder& decoder )
+{
+    for ( size_t segment = mNextSegment++; segment < mSegmentCount; segment = mNextSegment++ )
+    {
+        const size_t first = mOffsets[segment];
+        const size_t end = mOffsets[segment + 1];
+        DecodeSegment( decoder, mEdges + first, end - first, mEdges[end - 1] + mResetSamples, mSegments[segment] );
+    }
+}
+
+void SegmentStream::Start( LedDecoder& decoder, U64 firstEdge, DecoderOutput* output )
+{
+    mDecoder = &decoder;
+    mOutput = output;
+    mIsStartPending = false;
+    mDecoder->Start( firstEdge, this );
+}
+
+void SegmentStream::Push( const U64* edges, size_t count )
+{
+    assert( IsActive() );
+    mDecoder->Push( edges, count );
+}
+
+void SegmentStream::Finish( U64 idleSample )
+{
+    assert( IsActive() );
+    mDecoder->Idle( idleSample );
+    Clear();
+}
+
+void SegmentStream::Clear()
+{
+    mDecoder = nullptr;
+    mIsStartPending = false;
+}
+
+void SegmentStream::StartPacket()
+{
+    mIsStartPending = true;
+}
+
+void SegmentStream::AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed )
+{
+    PassStartedPacket();
+    mOutput->AddLed( rgb, beginSample, endSample, isHighSpeed );
+}
+
+void SegmentStream::EndPacket( bool isError, U64 packetEndSample )
+{
+    PassStartedPacket();
+    mOutput->EndPacket( isError, packetEndSample );
+}
+
+void SegmentStream::PassStartedPacket()
+{
+    if ( mIsStartPending )
+    {
+        mOutput->StartPacket();
+        mIsStartPending = false;
+    }
+}
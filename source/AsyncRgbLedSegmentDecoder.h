@@ -0,0 +1,160 @@
+#ifndef ASYNCRGBLED_SEGMENT_DECODER
+#define ASYNCRGBLED_SEGMENT_DECODER
+
+#include <AnalyzerTypes.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncRgbLedHelpers.h"
+#include "AsyncRgbLedDecoder.h"
+
+/// one LED decoded from a segment
+struct DecodedLed
+{
+    U64 mBeginSample;
+    U64 mEndSample;
+    RGBValue mRGB;
+};
+
+/// one packet decoded from a segment, with its LEDs in DecodedSegment::mLeds
+struct DecodedPacket
+{
+    size_t mFirstLed;
+    U32 mLedCount;
+
+    // the speed mode detected at the start of the packet
+    bool mIsHighSpeed;
+
+    // the packet ended at an invalid bit, rather than a reset
+    bool mIsError;
+    U64 mEndSample;
+};
+
+/**
+ * @brief DecodedSegment - every packet started inside a segment of the
+ * capture, in sample order, including packets without any LEDs.
+ */
+struct DecodedSegment
+{
+    std::vector<DecodedLed> mLeds;
+    std::vector<DecodedPacket> mPackets;
+};
+
+/**
+ * @brief DecodeSegment - decode a segment of the capture between two
+ * resets. The decoder restarts after every reset, so segments split at
+ * resets can be decoded independently, in any order.
+ *
+ * The first edge is the falling edge starting the reset before the segment,
+ * or the start of the capture, and the last is the falling edge starting
+ * the reset after it. The line stays low until idleSample, which has to be
+ * long enough for a reset.
+ */
+void DecodeSegment( LedDecoder& decoder, const U64* edges, size_t edgeCount, U64 idleSample,
+                    DecodedSegment& segment );
+
+/**
+ * @brief SegmentDecodePool - decoder threads kept for the length of an
+ * analysis, decoding batches of segments with DecodeSegment. Each thread
+ * has its own decoder and takes the next segment not yet decoded, so a few
+ * long packets don't leave the others idle. The thread handing over a batch
+ * decodes segments too, with the first decoder.
+ */
+class SegmentDecodePool
+{
+    public:
+        SegmentDecodePool() = default;
+        ~SegmentDecodePool();
+
+        SegmentDecodePool( const SegmentDecodePool& ) = delete;
+        SegmentDecodePool& operator=( const SegmentDecodePool& ) = delete;
+
+        /// create a decoder for each of threadCount threads, and start all
+        /// but the calling thread's, stopping any started before
+        void Start( const DecoderTiming& timing, U8 bitSize, ColorLayout layout, size_t threadCount );
+
+        void Stop();
+
+        /**
+         * @brief DecodeBatch - decode segmentCount segments, returning once
+         * all are decoded. Segment i runs from edges[offsets[i]] to
+         * edges[offsets[i + 1] - 1], and the line stays low for resetSamples
+         * after it.
+         */
+        void DecodeBatch( const U64* edges, const size_t* offsets, size_t segmentCount, U64 resetSamples,
+                          DecodedSegment* segments );
+
+        /// the decoder of the calling thread, free between batches
+        LedDecoder& FirstDecoder()
+        {
+            return *mDecoders[0];
+        }
+
+    private:
+        void WorkerThread( size_t index );
+        void DecodeSegments( LedDecoder& decoder );
+
+        std::vector<std::unique_ptr<LedDecoder>> mDecoders;
+        std::vector<std::thread> mThreads;
+
+        std::mutex mMutex;
+        std::condition_variable mBatchReady;
+        std::condition_variable mBatchDone;
+        U64 mBatchNumber = 0;
+        size_t mBusyWorkers = 0;
+        bool mIsStopping = false;
+
+        // the batch being decoded, set while no worker is busy
+        const U64* mEdges = nullptr;
+        const size_t* mOffsets = nullptr;
+        size_t mSegmentCount = 0;
+        U64 mResetSamples = 0;
+        DecodedSegment* mSegments = nullptr;
+        std::atomic<size_t> mNextSegment{0};
+};
+
+/**
+ * @brief SegmentStream - decode a segment too long to hold all its edges,
+ * passing its packets to the output as they are decoded. The packets are
+ * the same as DecodeSegment would find: the packet started at the reset
+ * ending the segment is left to the next segment.
+ */
+class SegmentStream : private DecoderOutput
+{
+    public:
+        /// firstEdge is the first edge of the segment, as for DecodeSegment
+        void Start( LedDecoder& decoder, U64 firstEdge, DecoderOutput* output );
+
+        void Push( const U64* edges, size_t count );
+
+        /// the segment ended with the line low until idleSample
+        void Finish( U64 idleSample );
+
+        /// forget the segment being decoded, without finishing it
+        void Clear();
+
+        bool IsActive() const
+        {
+            return mDecoder != nullptr;
+        }
+
+    private:
+        void StartPacket() override;
+        void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed ) override;
+        void EndPacket( bool isError, U64 packetEndSample ) override;
+
+        // a packet is only passed on once it has an LED or ends, so the one
+        // started at the last reset can be dropped
+        void PassStartedPacket();
+
+        LedDecoder* mDecoder = nullptr;
+        DecoderOutput* mOutput = nullptr;
+        bool mIsStartPending = false;
+};
+
+#endif // of #define ASYNCRGBLED_SEGMENT_DECODER
@@ -0,0 +1,99 @@
+#include "AsyncRgbLedTextCache.h"
+
+#include <algorithm> // for std::max()
+#include <iterator> // for std::prev()
+
+namespace
+{
+    // low bits of a key hold the display base and text kind
+    const U32 KEY_BASE_SHIFT = 1;
+    const U32 KEY_FRAME_SHIFT = 4;
+}
+
+ResultTextCache::ResultTextCache( size_t capacity ) :
+    mCapacity( std::max<size_t>( capacity, 1 ) )
+{
+}
+
+ResultTextCache::Strings ResultTextCache::Find( U64 frameIndex, DisplayBase base, TextKind kind )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    const auto it = mLookup.find( MakeKey( frameIndex, base, kind ) );
+
+    if ( it == mLookup.end() )
+    {
+        ++mMisses;
+        return Strings();
+    }
+
+    ++mHits;
+    mEntries.splice( mEntries.begin(), mEntries, it->second );
+    return it->second->mStrings;
+}
+
+ResultTextCache::Strings ResultTextCache::Insert( U64 frameIndex, DisplayBase base, TextKind kind,
+        std::vector<std::string>&& strings )
+{
+    // built outside the lock
+    const Strings stored = std::make_shared<const std::vector<std::string>>( std::move( strings ) );
+
+    std::lock_guard<std::mutex> lock( mMutex );
+    const U64 key = MakeKey( frameIndex, base, kind );
+    const auto it = mLookup.find( key );
+
+    if ( it != mLookup.end() )
+    {
+        it->second->mStrings = stored;
+        mEntries.splice( mEntries.begin(), mEntries, it->second );
+        return stored;
+    }
+
+    if ( mEntries.size() >= mCapacity )
+    {
+        // reuse the least recently used entry
+        mLookup.erase( mEntries.back().mKey );
+        mEntries.splice( mEntries.begin(), mEntries, std::prev( mEntries.end() ) );
+        mEntries.front().mKey = key;
+        mEntries.front().mStrings = stored;
+    }
+    else
+    {
+        mEntries.push_front( Entry{key, stored} );
+    }
+
+    mLookup[key] = mEntries.begin();
+    return stored;
+}
+
+void ResultTextCache::Clear()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    mEntries.clear();
+    mLookup.clear();
+    mHits = 0;
+    mMisses = 0;
+}
+
+U64 ResultTextCache::Hits() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mHits;
+}
+
+U64 ResultTextCache::Misses() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mMisses;
+}
+
+double ResultTextCache::HitRate() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    const U64 lookups = mHits + mMisses;
+    return ( lookups > 0 ) ? static_cast<double>( mHits ) / lookups : 0.0;
+}
+
+U64 ResultTextCache::MakeKey( U64 frameIndex, DisplayBase base, TextKind kind )
+{
+    return ( frameIndex << KEY_FRAME_SHIFT ) | ( static_cast<U64>( base ) << KEY_BASE_SHIFT ) | kind;
+}
@@ -0,0 +1,74 @@
+#ifndef ASYNCRGBLED_TEXT_CACHE
+#define ASYNCRGBLED_TEXT_CACHE
+
+#include <AnalyzerTypes.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief ResultTextCache - the bubble and tabular strings of recently shown
+ * frames, keyed by frame index and display base. Panning across a capture
+ * asks for the same frames repeatedly, so they are formatted once and the
+ * least recently used strings are dropped when the cache is full.
+ *
+ * Frames never change once added, so entries stay valid for the lifetime
+ * of the results. Text may be requested from several threads, so all
+ * access is serialised by a mutex. The strings are shared and immutable,
+ * so a hit only copies a pointer, and they stay valid after eviction.
+ */
+class ResultTextCache
+{
+    public:
+        enum TextKind
+        {
+            BUBBLE_TEXT = 0,
+            TABULAR_TEXT
+        };
+
+        typedef std::shared_ptr<const std::vector<std::string>> Strings;
+
+        static const size_t DEFAULT_CAPACITY = 4096;
+
+        explicit ResultTextCache( size_t capacity = DEFAULT_CAPACITY );
+
+        /// the cached strings of a frame, or null if not cached
+        Strings Find( U64 frameIndex, DisplayBase base, TextKind kind );
+
+        /// store the strings of a frame, returning the stored copy
+        Strings Insert( U64 frameIndex, DisplayBase base, TextKind kind, std::vector<std::string>&& strings );
+
+        void Clear();
+
+        /// lookup counters, for tuning the capacity
+        U64 Hits() const;
+        U64 Misses() const;
+
+        /// fraction of lookups which were hits, zero before any lookup
+        double HitRate() const;
+
+    private:
+        static U64 MakeKey( U64 frameIndex, DisplayBase base, TextKind kind );
+
+        struct Entry
+        {
+            U64 mKey;
+            Strings mStrings;
+        };
+
+        mutable std::mutex mMutex;
+        size_t mCapacity;
+
+        // most recently used first
+        std::list<Entry> mEntries;
+        std::unordered_map<U64, std::list<Entry>::iterator> mLookup;
+
+        U64 mHits = 0;
+        U64 mMisses = 0;
+};
+
+#endif // of #define ASYNCRGBLED_TEXT_CACHE
@@ -6,10 +6,31 @@
 #include "MockSimulatedChannelDescriptor.h"
 #include "TestMacros.h"
 
+#include "AsyncRgbLedAnalyzer.h"
+#include "AsyncRgbLedAnalyzerSettings.h"
+#include "AsyncRgbLedAnalyzerResults.h"
+#include "AsyncRgbLedBatchClassifier.h"
+#include "AsyncRgbLedBitstream.h"
+#include "AsyncRgbLedCApi.h"
+#include "AsyncRgbLedColorArena.h"
+#include "AsyncRgbLedDecoder.h"
+#include "AsyncRgbLedEdgeCache.h"
+#include "AsyncRgbLedExport.h"
+#include "AsyncRgbLedLazyDecode.h"
+#include "AsyncRgbLedPacketIndex.h"
+#include "AsyncRgbLedTextCache.h"
+
 #include <cmath>
 #include <cassert>
 #include <exception>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
 
 namespace {
 
@@ -30,6 +51,12 @@ double offsetRandom()
     return normRand - 0.5;
 }
 
+/// the packet a frame belongs to, from both fields it is stored in
+U32 framePacketSequence(const Frame& frame)
+{
+    return FramePacketSequence(frame.mData2, frame.mType);
+}
+
 } // of anonymous namespace
 
 const Channel TEST_CHANNEL = Channel(0, 0, DIGITAL_CHANNEL);
@@ -219,6 +246,13 @@ public:
                 double longTime = tm.longestDuration() * 1.5;
                 mAccumulatedError =
                         mChannelData->TestAppendIntervals(mSampleRate, mAccumulatedError, {longTime, longTime});
+            } else if (token == "partial_reset") {
+                // a single channel, then a reset part way through the LED
+                std::vector<double> result;
+                appendChannelWord(result, 0x5a);
+                result.back() = resetPulseDuration();
+                mAccumulatedError =
+                        mChannelData->TestAppendIntervals(mSampleRate, mAccumulatedError, result);
             } else if (token.at(0) == '#') {
                 // append a simple color
                 std::vector<double> result;
@@ -310,6 +344,31 @@ U64 rgb_triple_as_u64(U16 red, U16 green, U16 blue)
     return result;
 }
 
+std::string exportFileContents(Instance& plugin, DisplayBase base, U32 exportType)
+{
+    const char* exportPath = "AsyncRgbLedTestExport.tmp";
+    plugin.GetResults()->GenerateExportFile(exportPath, base, exportType);
+
+    std::ostringstream contents;
+    {
+        std::ifstream exportFile(exportPath, std::ios::binary);
+        contents << exportFile.rdbuf();
+    }
+    std::remove(exportPath);
+    return contents.str();
+}
+
+std::vector<std::string> exportTextLines(Instance& plugin, DisplayBase base)
+{
+    std::istringstream contents(exportFileContents(plugin, base, AsyncRgbLedAnalyzerSettings::EXPORT_CSV));
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(contents, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
 void setupStandardTestSettings(Instance& plugin, const std::string& controllerName)
 {
     plugin.SetSampleRate(40000000);
@@ -325,6 +384,79 @@ void setupStandardTestSettings(Instance& plugin, const std::string& controllerNa
     plugin.GetSettings()->SetSettingsFromInterfaces();
 }
 
+// called on the settings of a plugin before it analyzes a capture
+typedef std::function<void(AsyncRgbLedAnalyzerSettings*)> SettingsHook;
+
+void generateChannelData(Instance& plugin, MockChannelData& channelData, const std::string& text,
+                         const LedChannelDataGenerator::ModeTiming& timing = WS2812B)
+{
+    channelData.TestSetInitialBitState(BIT_LOW);
+
+    LedChannelDataGenerator generator;
+    generator.AddMode(timing);
+    if (timing.isGRB) {
+        generator.SetGRBLayout();
+    }
+    generator.SetSampleRate(plugin.GetSampleRate());
+    generator.SetMockChannel(&channelData);
+    generator.appendFromText(text);
+    generator.ResetToStart();
+}
+
+std::vector<Frame> analyzeChannel(Instance& plugin, MockChannelData& channelData)
+{
+    channelData.ResetCurrentSample();
+    plugin.SetChannelData(TEST_CHANNEL, &channelData);
+    auto rr = plugin.RunAnalyzerWorker();
+    TEST_VERIFY_EQ(rr, Instance::WorkerRanOutOfData);
+
+    auto results = MockResultData::MockFromResults(plugin.GetResults());
+    std::vector<Frame> frames;
+    for (U64 f = 0; f < results->TotalFrameCount(); ++f) {
+        frames.push_back(results->GetFrame(f));
+    }
+    return frames;
+}
+
+// set up the plugin for a controller, then generate and analyze the LEDs
+// of text, leaving the results in the plugin
+std::vector<Frame> analyzeText(Instance& plugin, MockChannelData& channelData,
+                               const std::string& controller,
+                               const LedChannelDataGenerator::ModeTiming& timing,
+                               const std::string& text,
+                               const SettingsHook& configure = SettingsHook())
+{
+    setupStandardTestSettings(plugin, controller);
+    if (configure) {
+        configure(static_cast<AsyncRgbLedAnalyzerSettings*>(plugin.GetSettings()));
+    }
+    generateChannelData(plugin, channelData, text, timing);
+    return analyzeChannel(plugin, channelData);
+}
+
+std::vector<Frame> analyzeText(const std::string& controller,
+                               const LedChannelDataGenerator::ModeTiming& timing,
+                               const std::string& text,
+                               const SettingsHook& configure = SettingsHook())
+{
+    Instance plugin{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&plugin);
+    return analyzeText(plugin, channelData, controller, timing, text, configure);
+}
+
+void verifySameFrames(const std::vector<Frame>& frames, const std::vector<Frame>& expected)
+{
+    TEST_VERIFY_EQ(frames.size(), expected.size());
+    for (size_t f = 0; f < frames.size(); ++f) {
+        TEST_VERIFY_EQ(frames[f].mStartingSampleInclusive, expected[f].mStartingSampleInclusive);
+        TEST_VERIFY_EQ(frames[f].mEndingSampleInclusive, expected[f].mEndingSampleInclusive);
+        TEST_VERIFY_EQ(frames[f].mData1, expected[f].mData1);
+        TEST_VERIFY_EQ(frames[f].mData2, expected[f].mData2);
+        TEST_VERIFY_EQ(frames[f].mType, expected[f].mType);
+        TEST_VERIFY_EQ(frames[f].mFlags, expected[f].mFlags);
+    }
+}
+
 void testBasicAnalysis(const std::string& controller,
                        LedChannelDataGenerator* generator)
 {
@@ -353,16 +485,27 @@ void testBasicAnalysis(const std::string& controller,
     auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
 
     TEST_VERIFY_EQ(results->TotalFrameCount(), 12);
-    TEST_VERIFY_EQ(results->TotalCommitCount(), 14) // commit per frame and per packet right now;
+    TEST_VERIFY_EQ(results->TotalCommitCount(), 2) // one commit per complete packet with the default policy
     TEST_VERIFY_EQ(results->TotalPacketCount(), 3); // FIXME - analyzer is appending a final packet
 
     // verify LED indices between reset pulses
-    TEST_VERIFY_EQ(results->GetFrame(2).mData2, 2);
-    TEST_VERIFY_EQ(results->GetFrame(3).mData2, 3);
-    TEST_VERIFY_EQ(results->GetFrame(5).mData2, 5);
-    TEST_VERIFY_EQ(results->GetFrame(6).mData2, 0);
-    TEST_VERIFY_EQ(results->GetFrame(7).mData2, 1);
-    TEST_VERIFY_EQ(results->GetFrame(11).mData2, 5);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(2).mData2), 2);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(3).mData2), 3);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(5).mData2), 5);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(6).mData2), 0);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(7).mData2), 1);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(11).mData2), 5);
+
+    // each frame records its packet, matching the packets of the results
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(5)), 0);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(6)), 1);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(11)), 1);
+
+    // packet IDs keep 32 bits, past what fits in mData2
+    const U64 longSequence = (U64(1) << 24) + 5;
+    TEST_VERIFY_EQ(FramePacketSequence(PackFrameData2(longSequence, 3), PackFrameType(longSequence)), longSequence);
+    TEST_VERIFY_EQ(FramePacketSequence(PackFrameData2(0xffffffff, 3), PackFrameType(0xffffffff)), 0xffffffffu);
+    TEST_VERIFY_EQ(results->GetFrame(0).mFlags, results->GetFrame(11).mFlags);
 
     TEST_VERIFY_EQ(results->GetFrame(0).mData1, rgb_triple_as_u64(0xab, 0xba, 0xde));
     TEST_VERIFY_EQ(results->GetFrame(2).mData1, rgb_triple_as_u64(0x66, 0x77, 0x88));
@@ -373,6 +516,17 @@ void testBasicAnalysis(const std::string& controller,
     TEST_VERIFY_EQ(results->GetFrameRangeForPacket(0), MockResultData::FrameRange(0, 5));
     TEST_VERIFY_EQ(results->GetFrameRangeForPacket(1), MockResultData::FrameRange(6, 11));
 
+    // seeking by sample through the packet index
+    auto ledResults = static_cast<AsyncRgbLedAnalyzerResults*>(pluginInstance.GetResults());
+    AsyncRgbLedAnalyzerResults::LedPosition position;
+    const Frame seekFrame = results->GetFrame(8);
+    TEST_VERIFY(ledResults->FindLedAtSample((seekFrame.mStartingSampleInclusive + seekFrame.mEndingSampleInclusive) / 2, position));
+    TEST_VERIFY_EQ(position.mFrame, 8);
+    TEST_VERIFY_EQ(position.mPacketId, 1);
+    TEST_VERIFY_EQ(position.mLedIndex, 2);
+    TEST_VERIFY(!ledResults->FindLedAtSample(results->GetFrame(5).mEndingSampleInclusive + 1, position));
+    TEST_VERIFY(!ledResults->FindLedAtSample(0, position));
+
     // bubble text generation
     pluginInstance.GenerateBubbleText(2, TEST_CHANNEL, Decimal);
     TEST_VERIFY_EQ(results->TotalStringCount(), 4);
@@ -386,9 +540,1113 @@ void testBasicAnalysis(const std::string& controller,
     TEST_VERIFY_EQ(results->TotalTabularTextCount(), 1);
     TEST_VERIFY_EQ(results->GetTabularText(0), "[2] 102, 119, 136");
 
+    // the second request for the same text comes from the cache
+    const U64 cacheHits = ledResults->TextCache().Hits();
+    pluginInstance.GenerateBubbleText(2, TEST_CHANNEL, Decimal);
+    TEST_VERIFY_EQ(ledResults->TextCache().Hits(), cacheHits + 1);
+    TEST_VERIFY_EQ(results->TotalStringCount(), 4);
+    TEST_VERIFY_EQ(results->GetString(2), "(2) #667788")
+    pluginInstance.GenerateBubbleText(2, TEST_CHANNEL, Hexadecimal);
+    TEST_VERIFY_EQ(ledResults->TextCache().Hits(), cacheHits + 1);
+    TEST_VERIFY_EQ(results->GetString(1), "2 R: 0x66 G: 0x77 B: 0x88 #667788")
+
+    // panning back and forth over the frames only formats each one once
+    const U64 hitsBefore = ledResults->TextCache().Hits();
+    const U64 missesBefore = ledResults->TextCache().Misses();
+    for (int pass = 0; pass < 4; ++pass) {
+        for (U64 f = 0; f < results->TotalFrameCount(); ++f) {
+            pluginInstance.GenerateBubbleText(f, TEST_CHANNEL, Binary);
+        }
+    }
+    TEST_VERIFY_EQ(ledResults->TextCache().Misses() - missesBefore, results->TotalFrameCount());
+    TEST_VERIFY_EQ(ledResults->TextCache().Hits() - hitsBefore, 3 * results->TotalFrameCount());
+
+    // export file generation
+    const auto exportLines = exportTextLines(pluginInstance, Decimal);
+
+    TEST_VERIFY_EQ(exportLines.size(), 13);
+    TEST_VERIFY_EQ(exportLines.at(0), "Time [s], Packet ID, LED Index, Red, Green, Blue, Web-CSS");
+    TEST_VERIFY_EQ(exportLines.at(3).substr(exportLines.at(3).find(',')), ",0,2,102,119,136,#667788");
+    TEST_VERIFY_EQ(exportLines.at(8).substr(exportLines.at(8).find(',')), ",1,1,34,51,68,#223344");
+
+    // binary export
+    const std::string binary = exportFileContents(pluginInstance, Decimal, AsyncRgbLedAnalyzerSettings::EXPORT_BINARY);
+
+    TEST_VERIFY_EQ(binary.size(), sizeof(BinaryExportHeader) + 12 * sizeof(BinaryExportRecord) + 2 * sizeof(BinaryExportPacket));
+    BinaryExportHeader header;
+    std::memcpy(&header, binary.data(), sizeof(header));
+    TEST_VERIFY_EQ(std::string(header.mMagic), "ARGBLED");
+    TEST_VERIFY_EQ(header.mVersion, BINARY_EXPORT_VERSION);
+    TEST_VERIFY_EQ(header.mBitSize, 8);
+    TEST_VERIFY_EQ(header.mSampleRateHz, pluginInstance.GetSampleRate());
+    TEST_VERIFY_EQ(header.mRecordCount, 12);
+    TEST_VERIFY_EQ(header.mPacketCount, 2);
+
+    BinaryExportRecord record;
+    std::memcpy(&record, binary.data() + header.mRecordsOffset + 7 * sizeof(record), sizeof(record));
+    TEST_VERIFY_EQ(record.mPacketId, 1);
+    TEST_VERIFY_EQ(record.mLedIndex, 1);
+    TEST_VERIFY_EQ(record.mRed, 0x22);
+    TEST_VERIFY_EQ(record.mGreen, 0x33);
+    TEST_VERIFY_EQ(record.mBlue, 0x44);
+    TEST_VERIFY_EQ(record.mStartSample, results->GetFrame(7).mStartingSampleInclusive);
+    TEST_VERIFY_EQ(record.mEndSample, results->GetFrame(7).mEndingSampleInclusive);
+
+    BinaryExportPacket packet;
+    std::memcpy(&packet, binary.data() + header.mPacketTableOffset + sizeof(packet), sizeof(packet));
+    TEST_VERIFY_EQ(packet.mPacketId, 1);
+    TEST_VERIFY_EQ(packet.mFirstRecord, 6);
+    TEST_VERIFY_EQ(packet.mRecordCount, 6);
+
     std::cout << "passed test basic analysis ok for " << controller << std::endl;
 }
 
+int runCommitPolicyAnalysis(U32 commitFrameCount, double commitIntervalSec)
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    const auto frames = analyzeText(pluginInstance, channelData, "WS2811", WS2811_normal_speed,
+                                    "reset,"
+                                    "#abbade,#223344,#667788,#cfcfcf,#deadbe,#7f7f7f_reset,"
+                                    "#aaddcc,#223344,#667788,#998877,#eeddff,#123456_reset",
+                                    [=](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mCommitFrameCount = commitFrameCount;
+        settings->mCommitIntervalSec = commitIntervalSec;
+    });
+
+    TEST_VERIFY_EQ(frames.size(), 12);
+    return MockResultData::MockFromResults(pluginInstance.GetResults())->TotalCommitCount();
+}
+
+void testCommitPolicy()
+{
+    // batches of four: one full batch, then the remaining two at packet end
+    TEST_VERIFY_EQ(runCommitPolicyAnalysis(4, 1.0), 4);
+
+    // batch size dividing the packet: nothing left pending at packet end
+    TEST_VERIFY_EQ(runCommitPolicyAnalysis(3, 1.0), 4);
+
+    // a tiny time budget commits every frame, leaving nothing for packet end
+    TEST_VERIFY_EQ(runCommitPolicyAnalysis(256, 1e-9), 12);
+
+    std::cout << "passed test: commit policy" << std::endl;
+}
+
+template <typename Source>
+void verifyPacketColors(Source& source, U64 packet, const std::vector<RGBValue>& expected)
+{
+    // read back from an offset, asking for more than the packet holds
+    std::vector<RGBValue> readBack(expected.size() + 4);
+    const U32 first = packet % 2;
+    const U32 count = source.GetColors(packet, first, static_cast<U32>(readBack.size()), readBack.data());
+    TEST_VERIFY_EQ(count, expected.size() - first);
+    for (U32 i = 0; i < count; ++i) {
+        TEST_VERIFY_EQ(readBack[i].ConvertToU64(), expected[first + i].ConvertToU64());
+    }
+}
+
+void verifyArenaPacket(const LedColorArena& arena, U64 packet, const std::vector<RGBValue>& expected)
+{
+    TEST_VERIFY_EQ(arena.PacketLedCount(packet), expected.size());
+    verifyPacketColors(arena, packet, expected);
+}
+
+void testColorArena()
+{
+    for (U8 bitSize : {8, 12}) {
+        LedColorArena arena;
+        arena.Clear(bitSize, 3);
+
+        // packets grow and shrink, and change a few LEDs each time
+        const U16 mask = static_cast<U16>((1 << bitSize) - 1);
+        std::vector<std::vector<RGBValue>> packets;
+        for (U32 p = 0; p < 11; ++p) {
+            const U32 ledCount = 40 + (p * 37) % 50;
+            std::vector<RGBValue> colors;
+            for (U32 led = 0; led < ledCount; ++led) {
+                const U32 changes = (led % 7 == p % 7) ? p : 0;
+                colors.push_back(RGBValue(static_cast<U16>((led * 7 + changes) & mask),
+                                          static_cast<U16>((led * 131 + 3) & mask),
+                                          static_cast<U16>((mask - led) & mask)));
+            }
+            TEST_VERIFY_EQ(arena.AddPacket(colors.data(), static_cast<U32>(colors.size())), p);
+            packets.push_back(colors);
+        }
+
+        TEST_VERIFY_EQ(arena.PacketCount(), packets.size());
+
+        // in order, in reverse, and jumping around
+        for (U32 p = 0; p < packets.size(); ++p) {
+            verifyArenaPacket(arena, p, packets[p]);
+        }
+        for (U32 p = packets.size(); p > 0; --p) {
+            verifyArenaPacket(arena, p - 1, packets[p - 1]);
+        }
+        for (U32 p : {7, 2, 10, 5, 5, 0, 8}) {
+            verifyArenaPacket(arena, p, packets[p]);
+        }
+
+        RGBValue unused;
+        TEST_VERIFY_EQ(arena.GetColors(packets.size(), 0, 1, &unused), 0);
+
+        // readers keep their own decoded packet, so interleaving them, or
+        // reading on several threads at once, gives the same colors
+        LedColorArena::Reader forward(arena);
+        LedColorArena::Reader backward(arena);
+        for (U32 p = 0; p < packets.size(); ++p) {
+            const U32 q = static_cast<U32>(packets.size()) - 1 - p;
+            verifyPacketColors(forward, p, packets[p]);
+            verifyPacketColors(backward, q, packets[q]);
+        }
+        TEST_VERIFY_EQ(forward.GetColors(packets.size(), 0, 1, &unused), 0);
+
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&arena, &packets]() {
+                LedColorArena::Reader reader(arena);
+                for (U32 p = 0; p < packets.size(); ++p) {
+                    verifyPacketColors(reader, p, packets[p]);
+                }
+            });
+        }
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+    }
+
+    // unchanging content is stored as little more than the change bitmaps
+    LedColorArena staticArena;
+    staticArena.Clear(8);
+    std::vector<RGBValue> colors(1000, RGBValue(0x12, 0x34, 0x56));
+    for (U32 p = 0; p < 64; ++p) {
+        staticArena.AddPacket(colors.data(), static_cast<U32>(colors.size()));
+    }
+    TEST_VERIFY(staticArena.StoredBits() * 10 < 64 * 1000 * 24);
+    verifyArenaPacket(staticArena, 63, colors);
+
+    std::cout << "passed test: color arena" << std::endl;
+}
+
+void testFilteredExport(AsyncRgbLedAnalyzerSettings::ResultsMode resultsMode)
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    analyzeText(pluginInstance, channelData, "WS2811", WS2811_normal_speed,
+                "reset,"
+                "#abbade,#223344,#667788,#cfcfcf,#deadbe,#7f7f7f_reset,"
+                "#aaddcc,#223344,#667788,#998877,#eeddff,#123456_reset,"
+                "#010203,#040506,#070809_reset",
+                [=](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mResultsMode = resultsMode;
+    });
+
+    // LEDs 1-2 of a window starting part-way into the last LED of the first
+    // packet, and ending part-way into the last LED of the third
+    auto ledResults = static_cast<AsyncRgbLedAnalyzerResults*>(pluginInstance.GetResults());
+    AsyncRgbLedAnalyzerResults::LedPosition position;
+    const double sampleRate = pluginInstance.GetSampleRate();
+    auto settings = static_cast<AsyncRgbLedAnalyzerSettings*>(pluginInstance.GetSettings());
+
+    auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
+    const Frame lastFrame = results->GetFrame(results->TotalFrameCount() - 1);
+    TEST_VERIFY(ledResults->FindLedAtSample(lastFrame.mEndingSampleInclusive, position));
+    TEST_VERIFY_EQ(position.mPacketId, 2);
+
+    settings->mHasExportStart = true;
+    settings->mExportStartSec = 0.000375;
+    settings->mHasExportEnd = true;
+    settings->mExportEndSec = 0.00103;
+    settings->mExportFirstLed = 1;
+    settings->mExportLastLed = 2;
+
+    TEST_VERIFY(ledResults->FindLedAtSample(static_cast<U64>(settings->mExportStartSec * sampleRate), position));
+    TEST_VERIFY_EQ(position.mPacketId, 0);
+    TEST_VERIFY(ledResults->FindLedAtSample(static_cast<U64>(settings->mExportEndSec * sampleRate), position));
+    TEST_VERIFY_EQ(position.mPacketId, 2);
+
+    const auto exportLines = exportTextLines(pluginInstance, Hexadecimal);
+    TEST_VERIFY_EQ(exportLines.size(), 5);
+    TEST_VERIFY_EQ(exportLines.at(1).substr(exportLines.at(1).find(',')), ",1,1,0x22,0x33,0x44,#223344");
+    TEST_VERIFY_EQ(exportLines.at(2).substr(exportLines.at(2).find(',')), ",1,2,0x66,0x77,0x88,#667788");
+    TEST_VERIFY_EQ(exportLines.at(3).substr(exportLines.at(3).find(',')), ",2,1,0x04,0x05,0x06,#040506");
+    TEST_VERIFY_EQ(exportLines.at(4).substr(exportLines.at(4).find(',')), ",2,2,0x07,0x08,0x09,#070809");
+
+    const std::string binary = exportFileContents(pluginInstance, Decimal, AsyncRgbLedAnalyzerSettings::EXPORT_BINARY);
+    BinaryExportHeader header;
+    std::memcpy(&header, binary.data(), sizeof(header));
+    TEST_VERIFY_EQ(header.mRecordCount, 4);
+    TEST_VERIFY_EQ(header.mPacketCount, 2);
+    TEST_VERIFY_EQ(binary.size(), sizeof(BinaryExportHeader) + 4 * sizeof(BinaryExportRecord) + 2 * sizeof(BinaryExportPacket));
+
+    // a window before the first packet exports nothing
+    settings->mExportStartSec = 0.0;
+    settings->mExportEndSec = 0.0;
+    TEST_VERIFY_EQ(exportTextLines(pluginInstance, Hexadecimal).size(), 1);
+
+    std::cout << "passed test: filtered export" << std::endl;
+}
+
+void testTextCache()
+{
+    ResultTextCache cache(2);
+    TEST_VERIFY(!cache.Find(1, Decimal, ResultTextCache::BUBBLE_TEXT));
+    TEST_VERIFY_EQ(cache.HitRate(), 0.0);
+
+    cache.Insert(1, Decimal, ResultTextCache::BUBBLE_TEXT, {"a", "b"});
+    cache.Insert(1, Decimal, ResultTextCache::TABULAR_TEXT, {"c"});
+    auto strings = cache.Find(1, Decimal, ResultTextCache::BUBBLE_TEXT);
+    TEST_VERIFY(strings);
+    TEST_VERIFY_EQ(strings->size(), 2);
+    TEST_VERIFY_EQ(strings->at(1), "b");
+    TEST_VERIFY(!cache.Find(1, Hexadecimal, ResultTextCache::BUBBLE_TEXT));
+
+    // a hit shares the stored strings rather than copying them
+    TEST_VERIFY(cache.Find(1, Decimal, ResultTextCache::BUBBLE_TEXT) == strings);
+
+    // the tabular text is now the least recently used, so it's replaced
+    cache.Insert(2, Decimal, ResultTextCache::BUBBLE_TEXT, {"d"});
+    TEST_VERIFY(!cache.Find(1, Decimal, ResultTextCache::TABULAR_TEXT));
+    TEST_VERIFY(cache.Find(1, Decimal, ResultTextCache::BUBBLE_TEXT));
+    TEST_VERIFY_EQ(cache.Find(2, Decimal, ResultTextCache::BUBBLE_TEXT)->at(0), "d");
+
+    // strings handed out stay valid after they are evicted
+    cache.Insert(3, Decimal, ResultTextCache::BUBBLE_TEXT, {"e"});
+    cache.Insert(4, Decimal, ResultTextCache::BUBBLE_TEXT, {"f"});
+    TEST_VERIFY(!cache.Find(1, Decimal, ResultTextCache::BUBBLE_TEXT));
+    TEST_VERIFY_EQ(strings->at(0), "a");
+
+    TEST_VERIFY_EQ(cache.Hits(), 4);
+    TEST_VERIFY_EQ(cache.Misses(), 4);
+    TEST_VERIFY_EQ(cache.HitRate(), 0.5);
+
+    std::cout << "passed test: text cache" << std::endl;
+}
+
+void testPacketIndex()
+{
+    PacketIndex index;
+    index.Add(PacketIndexEntry{100, 199, 0, 10, 10});
+    index.Add(PacketIndexEntry{300, 399, 10, 10, 10});
+    index.Add(PacketIndexEntry{500, 599, 20, 1, 10});
+    TEST_VERIFY_EQ(index.Count(), 3);
+
+    U64 packet = 0;
+    TEST_VERIFY(!index.FindPacketAtSample(99, packet));
+    TEST_VERIFY(index.FindPacketAtSample(100, packet));
+    TEST_VERIFY_EQ(packet, 0);
+    TEST_VERIFY(index.FindPacketAtSample(299, packet));
+    TEST_VERIFY_EQ(packet, 0);
+    TEST_VERIFY(index.FindPacketAtSample(300, packet));
+    TEST_VERIFY_EQ(packet, 1);
+    TEST_VERIFY(index.FindPacketAtSample(10000, packet));
+    TEST_VERIFY_EQ(packet, 2);
+
+    TEST_VERIFY_EQ(index.FirstPacketEndingAfter(0), 0);
+    TEST_VERIFY_EQ(index.FirstPacketEndingAfter(199), 0);
+    TEST_VERIFY_EQ(index.FirstPacketEndingAfter(200), 1);
+    TEST_VERIFY_EQ(index.FirstPacketEndingAfter(600), 3);
+
+    PacketIndexEntry entry;
+    TEST_VERIFY(index.Get(2, entry));
+    TEST_VERIFY_EQ(entry.mFirstFrame, 20);
+    TEST_VERIFY(!index.Get(3, entry));
+
+    std::cout << "passed test: packet index" << std::endl;
+}
+
+void testPacketMode()
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    analyzeText(pluginInstance, channelData, "WS2811", WS2811_normal_speed,
+                "reset,"
+                "#abbade,#223344,#667788,#cfcfcf,#deadbe,#7f7f7f,#010203,#040506,#070809,#0a0b0c_reset,"
+                "#aaddcc,#223344,#667788_reset",
+                [](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mResultsMode = AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET;
+    });
+
+    // one frame per packet, referring to the colors stored by the analyzer
+    auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
+    TEST_VERIFY_EQ(results->TotalFrameCount(), 2);
+    TEST_VERIFY_EQ(results->GetFrame(0).mFlags, FRAME_FLAG_PACKET);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(0).mData2), 10);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(1).mData2), 3);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(1)), 1);
+
+    pluginInstance.GenerateBubbleText(0, TEST_CHANNEL, Decimal);
+    TEST_VERIFY_EQ(results->GetString(0), "Packet 10 LEDs: #abbade #223344 #667788 #cfcfcf #deadbe #7f7f7f #010203 #040506 ...");
+    TEST_VERIFY_EQ(results->GetString(1), "10 LEDs: #abbade ...");
+
+    pluginInstance.GenerateBubbleText(1, TEST_CHANNEL, Decimal);
+    TEST_VERIFY_EQ(results->GetString(0), "Packet 3 LEDs: #aaddcc #223344 #667788");
+
+    // seeking into a packet frame finds the LED from its evenly spaced position
+    auto ledResults = static_cast<AsyncRgbLedAnalyzerResults*>(pluginInstance.GetResults());
+    AsyncRgbLedAnalyzerResults::LedPosition position;
+    TEST_VERIFY(ledResults->FindLedAtSample(results->GetFrame(0).mEndingSampleInclusive, position));
+    TEST_VERIFY_EQ(position.mFrame, 0);
+    TEST_VERIFY_EQ(position.mLedIndex, 9);
+    TEST_VERIFY(ledResults->FindLedAtSample(results->GetFrame(1).mStartingSampleInclusive, position));
+    TEST_VERIFY_EQ(position.mPacketId, 1);
+    TEST_VERIFY_EQ(position.mLedIndex, 0);
+
+    // export expands the packets back into LEDs
+    const auto exportLines = exportTextLines(pluginInstance, Hexadecimal);
+
+    TEST_VERIFY_EQ(exportLines.size(), 14);
+    TEST_VERIFY_EQ(exportLines.at(10).substr(exportLines.at(10).find(',')), ",0,9,0x0A,0x0B,0x0C,#0a0b0c");
+    TEST_VERIFY_EQ(exportLines.at(13).substr(exportLines.at(13).find(',')), ",1,2,0x66,0x77,0x88,#667788");
+
+    std::cout << "passed test: packet mode" << std::endl;
+}
+
+std::vector<std::string> analyzeAndExport(const std::string& controller,
+                                          const LedChannelDataGenerator::ModeTiming& timing,
+                                          AsyncRgbLedAnalyzerSettings::ResultsMode resultsMode,
+                                          U64* frameFlags)
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    const auto frames = analyzeText(pluginInstance, channelData, controller, timing,
+                                    "reset,"
+                                    "#abbade,#223344,#667788,#cfcfcf,#deadbe,#7f7f7f,#010203,#040506,#070809,#0a0b0c_reset,"
+                                    "#aaddcc_reset,"
+                                    "#aaddcc,#223344,#667788_reset",
+                                    [=](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mResultsMode = resultsMode;
+    });
+
+    TEST_VERIFY_EQ(frames.size(), 3);
+    *frameFlags = frames[0].mFlags;
+
+    auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
+    pluginInstance.GenerateBubbleText(1, TEST_CHANNEL, Decimal);
+    TEST_VERIFY_EQ(results->GetString(0), "Packet 1 LEDs: #aaddcc");
+
+    // drop the time column, since that depends on the LED spacing
+    std::vector<std::string> rows;
+    for (const std::string& line : exportTextLines(pluginInstance, Hexadecimal)) {
+        rows.push_back(line.substr(line.find(',')));
+    }
+    return rows;
+}
+
+void testTimelineMode(const std::string& controller,
+                      const LedChannelDataGenerator::ModeTiming& timing,
+                      bool isHighSpeed)
+{
+    // the timeline scan only stores pulses, but decodes the same LEDs when
+    // they are read back
+    U64 packetFlags = 0;
+    U64 timelineFlags = 0;
+    const auto packetRows = analyzeAndExport(controller, timing, AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET, &packetFlags);
+    const auto timelineRows = analyzeAndExport(controller, timing, AsyncRgbLedAnalyzerSettings::RESULTS_TIMELINE, &timelineFlags);
+
+    TEST_VERIFY_EQ(packetFlags, FRAME_FLAG_PACKET | (isHighSpeed ? FRAME_FLAG_HIGH_SPEED : 0));
+    TEST_VERIFY_EQ(timelineFlags, FRAME_FLAG_PACKET | FRAME_FLAG_LAZY);
+    TEST_VERIFY_EQ(timelineRows.size(), 15);
+    TEST_VERIFY(timelineRows == packetRows);
+
+    std::cout << "passed test: timeline mode for " << controller << std::endl;
+}
+
+void testParallelDecode(const std::string& controller,
+                        const LedChannelDataGenerator::ModeTiming& timing)
+{
+    // starts without a reset, and includes every kind of error
+    const std::string text = "#010203,mangled_too_short,reset,"
+                             "#aabbcc,#223344,#667788,#cfcfcf,mangled_too_short,#7f7f7f_reset,"
+                             "#aabbcc,#223344,mangled_too_long,#998877,#eeddff,#123456_reset,"
+                             "#ddeeff,#112233,partial_reset,"
+                             "#445566,#445566,#445566,#987654_reset,"
+                             "#000000_reset";
+    const AsyncRgbLedAnalyzerSettings::ResultsMode modes[] = {
+        AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED,
+        AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET,
+        AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH
+    };
+
+    for (auto mode : modes) {
+        const auto expected = analyzeText(controller, timing, text, [mode](AsyncRgbLedAnalyzerSettings* settings) {
+            settings->mResultsMode = mode;
+        });
+        const auto frames = analyzeText(controller, timing, text, [mode](AsyncRgbLedAnalyzerSettings* settings) {
+            settings->mResultsMode = mode;
+            settings->mDecodeThreadCount = 4;
+        });
+        verifySameFrames(frames, expected);
+
+        if (mode == AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED) {
+            // the LED cut short by a reset is dropped, and the next packet
+            // starts from LED zero
+            TEST_VERIFY_EQ(frames.size(), 13);
+            TEST_VERIFY_EQ(frames[8].mData1, rgb_triple_as_u64(0x44, 0x55, 0x66));
+            TEST_VERIFY_EQ(FrameLedIndex(frames[8].mData2), 0);
+            TEST_VERIFY_EQ(framePacketSequence(frames[8]), framePacketSequence(frames[7]) + 1);
+        }
+    }
+
+    std::cout << "passed test: parallel decode for " << controller << std::endl;
+}
+
+void testEdgeCache()
+{
+    // deltas of every encoded length, enough to fill several blocks
+    std::vector<U64> edges{U64(1) << 62};
+    for (int i = 0; i < 600000; ++i) {
+        const int bits = 1 + rand() % 40;
+        edges.push_back(edges.back() + 1 + ((U64(rand()) << 32 | U64(rand())) & ((U64(1) << bits) - 1)));
+    }
+
+    EdgeCache cache;
+    cache.Clear(1000);
+    for (size_t i = 0; i < edges.size(); i += 4096) {
+        const size_t count = std::min<size_t>(4096, edges.size() - i);
+        TEST_VERIFY_EQ(cache.Append(edges.data() + i, count), count);
+    }
+    TEST_VERIFY_EQ(cache.EdgeCount(), edges.size());
+    TEST_VERIFY_EQ(cache.LastEdge(), edges.back());
+    TEST_VERIFY(cache.ByteSize() > (1 << 20));
+
+    std::vector<U64> readBack;
+    for (EdgeCache::Reader reader(cache); reader.HasNext(); reader.Next()) {
+        readBack.push_back(reader.Peek());
+    }
+    TEST_VERIFY(readBack == edges);
+
+    // a byte per LED bit edge, three for the reset, and a full cache keeps the
+    // edges which fit
+    EdgeCache small(100);
+    small.Clear(0);
+    const U64 ledEdges[] = {100, 120, 150, 20150, 20200};
+    TEST_VERIFY_EQ(small.Append(ledEdges, 5), 5);
+    TEST_VERIFY_EQ(small.ByteSize(), 7);
+
+    std::vector<U64> moreEdges;
+    for (U64 i = 1; i <= 200; ++i) {
+        moreEdges.push_back(20200 + i * 30);
+    }
+    const size_t stored = small.Append(moreEdges.data(), moreEdges.size());
+    TEST_VERIFY(stored < moreEdges.size());
+    TEST_VERIFY(small.IsFull());
+    TEST_VERIFY_EQ(small.EdgeCount(), 5 + stored);
+    TEST_VERIFY_EQ(small.LastEdge(), moreEdges[stored - 1]);
+    TEST_VERIFY_EQ(small.Append(moreEdges.data(), 1), 0);
+
+    std::cout << "passed test: edge cache" << std::endl;
+}
+
+void testReanalysisFromCache()
+{
+    // long enough for the first edges checked against the cache to end
+    // well before the last packet
+    std::string text = "reset,#000000,#223344,#667788_reset,";
+    for (int led = 0; led < 100; ++led) {
+        text += "#aabbcc,";
+    }
+    text += "mangled_too_short,#998877_reset,"
+            "#445566,#445566,#987654_reset";
+
+    Instance plugin{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&plugin);
+    const auto ws2812b = analyzeText(plugin, channelData, "WS2812B", WS2812B, text);
+    TEST_VERIFY(!ws2812b.empty());
+
+    Instance fresh{"Addressable LEDs (Async)"};
+    setupStandardTestSettings(fresh, "WS2813");
+    const auto ws2813 = analyzeChannel(fresh, channelData);
+
+    // stretch a high pulse of the last LED, so reading the channel data
+    // decodes it differently
+    const std::vector<U64> original = channelData.mTransitions;
+    const size_t fallingEdge = (channelData.mTransitions.size() - 6) | 1;
+    channelData.mTransitions[fallingEdge] = channelData.mTransitions[fallingEdge + 1] - 1;
+    Instance changed{"Addressable LEDs (Async)"};
+    setupStandardTestSettings(changed, "WS2813");
+    const auto changedFrames = analyzeChannel(changed, channelData);
+    TEST_VERIFY(changedFrames.size() != ws2813.size() || changedFrames.back().mData1 != ws2813.back().mData1);
+
+    // changing the controller decodes the cached edges, matching a fresh
+    // analysis of the original data
+    setupStandardTestSettings(plugin, "WS2813");
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2813);
+
+    setupStandardTestSettings(plugin, "WS2812B");
+    auto settings = static_cast<AsyncRgbLedAnalyzerSettings*>(plugin.GetSettings());
+    settings->mDecodeThreadCount = 4;
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2812b);
+    settings->mDecodeThreadCount = 1;
+
+    // a different capture isn't read from the cache
+    MockChannelData otherData(&plugin);
+    generateChannelData(plugin, otherData, "reset,#123456,#abcdef_reset,#fedcba_reset");
+    Instance otherFresh{"Addressable LEDs (Async)"};
+    setupStandardTestSettings(otherFresh, "WS2812B");
+    verifySameFrames(analyzeChannel(plugin, otherData), analyzeChannel(otherFresh, otherData));
+
+    channelData.mTransitions = original;
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2812b);
+
+    // nor is a capture which only starts the same, here with a longer reset
+    // before the last packet: its later packets are read from the channel
+    // data once its edges differ at a reset
+    const U64 lastPacketStart = ws2812b[ws2812b.size() - 3].mStartingSampleInclusive;
+    MockChannelData laterData(&plugin);
+    laterData.TestSetInitialBitState(BIT_LOW);
+    for (U64 transition : original) {
+        laterData.mTransitions.push_back(transition + (transition >= lastPacketStart ? 500 : 0));
+    }
+    laterData.mEnd = channelData.mEnd + 500;
+    Instance laterFresh{"Addressable LEDs (Async)"};
+    setupStandardTestSettings(laterFresh, "WS2812B");
+    const auto laterFrames = analyzeChannel(laterFresh, laterData);
+    TEST_VERIFY(laterFrames.back().mStartingSampleInclusive != ws2812b.back().mStartingSampleInclusive);
+    verifySameFrames(analyzeChannel(plugin, laterData), laterFrames);
+    verifySameFrames(analyzeChannel(plugin, laterData), laterFrames);
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2812b);
+
+    // with no memory for the cache, every analysis reads the channel data
+    settings->mEdgeCacheMiB = 0;
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2812b);
+    verifySameFrames(analyzeChannel(plugin, channelData), ws2812b);
+    settings->mEdgeCacheMiB = AsyncRgbLedAnalyzerSettings::DEFAULT_EDGE_CACHE_MIB;
+
+    std::cout << "passed test: re-analysis from the edge cache" << std::endl;
+}
+
+void testParallelCaptureEnd()
+{
+    // a fixed-length capture of a strip refreshed continuously stops part
+    // way through a packet
+    const std::string text = "reset,#112233,#445566_reset,#778899,#aabbcc,#ddeeff";
+    const AsyncRgbLedAnalyzerSettings::ResultsMode modes[] = {
+        AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED,
+        AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET,
+        AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH
+    };
+
+    for (auto mode : modes) {
+        const auto analyze = [&text, mode](U32 decodeThreadCount) {
+            return analyzeText("WS2812B", WS2812B, text, [=](AsyncRgbLedAnalyzerSettings* settings) {
+                settings->mResultsMode = mode;
+                settings->mDecodeThreadCount = decodeThreadCount;
+            });
+        };
+
+        const auto expected = analyze(1);
+        // every LED of the unfinished packet is shown
+        if (mode == AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED) {
+            TEST_VERIFY_EQ(expected.size(), 5);
+            TEST_VERIFY_EQ(expected.back().mData1, rgb_triple_as_u64(0xdd, 0xee, 0xff));
+        }
+        verifySameFrames(analyze(4), expected);
+    }
+
+    std::cout << "passed test: parallel decode to the end of the capture" << std::endl;
+}
+
+void testParallelLongSegments()
+{
+    // a lead-in without any reset, and a packet with an error, each longer
+    // than a batch of two threads
+    std::string text;
+    for (int led = 0; led < 3000; ++led) {
+        text += "#102030,";
+    }
+    text += "reset,";
+    for (int led = 0; led < 3000; ++led) {
+        text += (led == 1500) ? "mangled_too_short," : "#405060,";
+    }
+    text += "#405060_reset,#708090,#a0b0c0_reset";
+
+    const auto analyze = [&text](U32 decodeThreadCount) {
+        return analyzeText("WS2812B", WS2812B, text, [=](AsyncRgbLedAnalyzerSettings* settings) {
+            settings->mDecodeThreadCount = decodeThreadCount;
+        });
+    };
+
+    const auto expected = analyze(1);
+    TEST_VERIFY_EQ(expected.size(), 1502);
+    verifySameFrames(analyze(2), expected);
+
+    std::cout << "passed test: parallel decode of long segments" << std::endl;
+}
+
+void testLiveLagTracker()
+{
+    LiveLagTracker lag;
+    lag.Configure(1000000, 0.02);
+    lag.Start();
+
+    // never behind until decoding has caught up with the capture once
+    TEST_VERIFY(!lag.IsBehind(0, 100.0));
+    TEST_VERIFY_EQ(lag.NewestSample(100.0), 0);
+
+    lag.CaughtUp(1000, 10.0);
+    TEST_VERIFY_EQ(lag.NewestSample(10.5), 501000);
+
+    // decoding faster than real time, as when a burst of data arrives
+    TEST_VERIFY(!lag.IsBehind(101000, 10.001));
+
+    // 30ms of wall-clock time, but only 5ms of signal decoded
+    TEST_VERIFY(!lag.IsBehind(6000, 10.02));
+    TEST_VERIFY(lag.IsBehind(6000, 10.03));
+
+    lag.CaughtUp(40000, 10.03);
+    TEST_VERIFY(!lag.IsBehind(40000, 10.03));
+
+    lag.Start();
+    TEST_VERIFY(!lag.IsBehind(40000, 20.0));
+
+    std::cout << "passed test: live lag tracker" << std::endl;
+}
+
+void testLiveMode()
+{
+    // a packet of 200 identical LEDs takes 6ms to send
+    std::string text = "reset,";
+    for (int led = 0; led < 200; ++led) {
+        text += "#405060,";
+    }
+    text += "#405060_reset";
+
+    const auto analyze = [&text](AsyncRgbLedAnalyzerSettings::ResultsMode resultsMode, U32 liveLatencyMs,
+                                 int* commitCount) {
+        Instance plugin{"Addressable LEDs (Async)"};
+        MockChannelData channelData(&plugin);
+        const auto frames = analyzeText(plugin, channelData, "WS2812B", WS2812B, text,
+                                        [=](AsyncRgbLedAnalyzerSettings* settings) {
+            settings->mResultsMode = resultsMode;
+            settings->mCommitIntervalSec = 1.0;
+            settings->mLiveLatencyMs = liveLatencyMs;
+            settings->mDecodeThreadCount = 4;
+        });
+        *commitCount = MockResultData::MockFromResults(plugin.GetResults())->TotalCommitCount();
+        return frames;
+    };
+
+    // the LEDs are committed while the packet is being sent, and are the same
+    int commitCount = 0;
+    int liveCommitCount = 0;
+    const auto frames = analyze(AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED, 0, &commitCount);
+    const auto liveFrames = analyze(AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED, 1, &liveCommitCount);
+    TEST_VERIFY_EQ(frames.size(), 201);
+    verifySameFrames(liveFrames, frames);
+    TEST_VERIFY(liveCommitCount >= 6);
+    TEST_VERIFY(liveCommitCount > commitCount);
+
+    // a long run is split into frames within the latency
+    const auto runFrames = analyze(AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH, 0, &commitCount);
+    const auto liveRunFrames = analyze(AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH, 1, &liveCommitCount);
+    TEST_VERIFY_EQ(runFrames.size(), 1);
+    TEST_VERIFY(liveRunFrames.size() >= 6);
+    TEST_VERIFY(liveCommitCount > commitCount);
+
+    // 1ms at the sample rate of the standard test settings
+    const U64 latencySamples = 40000;
+    U32 nextLed = 0;
+    for (const Frame& frame : liveRunFrames) {
+        TEST_VERIFY_EQ(frame.mData1, runFrames[0].mData1);
+        TEST_VERIFY_EQ(FrameLedIndex(frame.mData2), nextLed);
+        TEST_VERIFY(frame.mEndingSampleInclusive - frame.mStartingSampleInclusive < 2 * latencySamples);
+        nextLed = ((frame.mFlags & FRAME_FLAG_RUN) ? FrameLastLedIndex(frame.mData2) : FrameLedIndex(frame.mData2)) + 1;
+    }
+    TEST_VERIFY_EQ(nextLed, 201);
+    TEST_VERIFY_EQ(liveRunFrames.front().mStartingSampleInclusive, runFrames[0].mStartingSampleInclusive);
+    TEST_VERIFY_EQ(liveRunFrames.back().mEndingSampleInclusive, runFrames[0].mEndingSampleInclusive);
+
+    // skipping ahead while the decoder is waiting for a reset after bad
+    // data, with no packet open, ends no packet
+    std::string errorText = "reset,#112233,#445566,mangled_too_long,";
+    for (int led = 0; led < 100; ++led) {
+        errorText += "#405060,";
+    }
+    errorText += "#405060_reset,#708090,#a0b0c0_reset";
+
+    Instance plugin{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&plugin);
+    const auto errorFrames = analyzeText(plugin, channelData, "WS2812B", WS2812B, errorText,
+                                         [](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mLiveLatencyMs = 1;
+    });
+    TEST_VERIFY_EQ(errorFrames.size(), 4);
+    // the last LED before the bad data marks the end of its packet
+    TEST_VERIFY(!(errorFrames[0].mFlags & FRAME_FLAG_PACKET_ERROR));
+    TEST_VERIFY(errorFrames[1].mFlags & FRAME_FLAG_PACKET_ERROR);
+    TEST_VERIFY(!(errorFrames[3].mFlags & FRAME_FLAG_PACKET_ERROR));
+
+    auto analyzer = static_cast<AsyncRgbLedAnalyzer*>(plugin.mAnalyzer);
+    analyzer->ForceLiveSkip(errorFrames[1].mEndingSampleInclusive + 2 * latencySamples);
+    verifySameFrames(analyzeChannel(plugin, channelData), errorFrames);
+    TEST_VERIFY_EQ(analyzer->GetPacketIndex().Count(), 2);
+
+    auto ledResults = static_cast<AsyncRgbLedAnalyzerResults*>(plugin.GetResults());
+    AsyncRgbLedAnalyzerResults::LedPosition position;
+    TEST_VERIFY(ledResults->FindLedAtSample(errorFrames[3].mStartingSampleInclusive, position));
+    TEST_VERIFY_EQ(position.mFrame, 3);
+    TEST_VERIFY_EQ(position.mLedIndex, 1);
+
+    std::cout << "passed test: live mode" << std::endl;
+}
+
+class RecordingDecoderOutput : public DecoderOutput
+{
+public:
+    void StartPacket() override
+    {
+        mEvents.push_back("start");
+    }
+
+    void AddLed(const RGBValue& rgb, U64 beginSample, U64 endSample, bool isHighSpeed) override
+    {
+        std::ostringstream os;
+        os << "led " << std::hex << rgb.red << " " << rgb.green << " " << rgb.blue << std::dec << " " << beginSample << "-" << endSample;
+        mEvents.push_back(os.str());
+    }
+
+    void EndPacket(bool isError, U64 endSample) override
+    {
+        mEvents.push_back(std::string(isError ? "error " : "end ") + std::to_string(endSample));
+    }
+
+    std::vector<std::string> mEvents;
+};
+
+U64 midpoint(const SampleRange& range)
+{
+    return (range.mMinimum + range.mMaximum) / 2;
+}
+
+RGBValue makeRGB(U16 red, U16 green, U16 blue)
+{
+    RGBValue rgb;
+    rgb.red = red;
+    rgb.green = green;
+    rgb.blue = blue;
+    return rgb;
+}
+
+// the rising and falling edge of every bit of an LED, with nominal timing
+void appendLedEdges(const DecoderTiming& timing, U8 bitSize, ColorLayout layout, const RGBValue& rgb,
+                    U64 firstLowSamples, std::vector<U64>& edges)
+{
+    U16 values[3];
+    rgb.ConvertToControllerOrder(layout, values);
+    U64 lowSamples = firstLowSamples;
+    for (const U16 v : values) {
+        for (int b = bitSize - 1; b >= 0; --b) {
+            const BitSampleTiming& bit = timing.DataTiming(((v >> b) & 1) ? BIT_HIGH : BIT_LOW, false);
+            const U64 last = edges.empty() ? 0 : edges.back();
+            edges.push_back(last + lowSamples);
+            edges.push_back(edges.back() + midpoint(bit.mPositive));
+            lowSamples = midpoint(bit.mNegative);
+        }
+    }
+}
+
+std::vector<std::string> pushEdges(LedDecoder& decoder, const std::vector<U64>& edges, size_t chunkSize, U64 idleSample)
+{
+    RecordingDecoderOutput output;
+    decoder.Start(0, &output);
+    for (size_t i = 0; i < edges.size(); i += chunkSize) {
+        decoder.Push(edges.data() + i, std::min(chunkSize, edges.size() - i));
+    }
+    decoder.Idle(idleSample);
+    return output.mEvents;
+}
+
+size_t countEvents(const std::vector<std::string>& events, const std::string& prefix)
+{
+    return std::count_if(events.begin(), events.end(), [&prefix](const std::string& e) {
+        return e.compare(0, prefix.size(), prefix) == 0;
+    });
+}
+
+void testDecoderPush(const std::string& controller)
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    setupStandardTestSettings(pluginInstance, controller);
+    auto settings = static_cast<AsyncRgbLedAnalyzerSettings*>(pluginInstance.GetSettings());
+    const DecoderTiming timing = settings->SampleTiming(pluginInstance.GetSampleRate());
+    const U8 bitSize = settings->BitSize();
+    const ColorLayout layout = settings->GetColorLayout();
+    const U64 resetSamples = timing.mResetSamples + 10;
+
+    // packets of one LED, the last ended by a glitch, then a packet ended
+    // by the line staying idle
+    std::vector<U64> edges;
+    appendLedEdges(timing, bitSize, layout, makeRGB(0xab, 0xcd, 0xef), resetSamples, edges);
+    appendLedEdges(timing, bitSize, layout, makeRGB(0x12, 0x34, 0x56), resetSamples, edges);
+    appendLedEdges(timing, bitSize, layout, makeRGB(0x00, 0xff, 0x00), resetSamples, edges);
+    appendLedEdges(timing, bitSize, layout, makeRGB(0x01, 0x02, 0x03), resetSamples, edges);
+    edges.push_back(edges.back() + 1);
+    edges.push_back(edges.back() + 1);
+    appendLedEdges(timing, bitSize, layout, makeRGB(0x44, 0x55, 0x66), resetSamples, edges);
+
+    // the analyzer pushes edges as they arrive, in chunks of any size
+    const U64 idleSample = edges.back() + resetSamples;
+    auto decoder = LedDecoder::Create(timing, bitSize, layout);
+    const auto expected = pushEdges(*decoder, edges, edges.size(), idleSample);
+
+    for (const size_t chunkSize : {size_t(1), size_t(2), size_t(7), size_t(100)}) {
+        TEST_VERIFY(pushEdges(*decoder, edges, chunkSize, idleSample) == expected);
+    }
+
+    // the packet opened after the final reset stays empty
+    TEST_VERIFY_EQ(countEvents(expected, "start"), 6);
+    TEST_VERIFY_EQ(countEvents(expected, "led "), 4);
+    TEST_VERIFY_EQ(countEvents(expected, "error "), 1);
+    TEST_VERIFY_EQ(countEvents(expected, "end "), 4);
+    TEST_VERIFY_EQ(expected.at(1).compare(0, 12, "led ab cd ef"), 0);
+    TEST_VERIFY_EQ(expected.at(expected.size() - 3).compare(0, 12, "led 44 55 66"), 0);
+    TEST_VERIFY_EQ(expected.back(), "start");
+
+    std::cout << "passed test: decoder push for " << controller << std::endl;
+}
+
+void testLazyPacketStore()
+{
+    const U32 sampleRateHz = 20000000;
+    const LedControllerData& controller = GetLedControllerData(AsyncRgbLedAnalyzerSettings::LED_WS2812B);
+    const DecoderTiming timing = CreateDecoderTiming(controller, sampleRateHz);
+    const RGBValue colors[3] = {makeRGB(0x12, 0x34, 0x56), makeRGB(0xff, 0x00, 0x80), makeRGB(0x01, 0x02, 0x03)};
+
+    // the pulses of three LEDs, ended by a reset
+    std::vector<U64> edges;
+    for (const RGBValue& rgb : colors) {
+        const U64 firstLowSamples = edges.empty() ? timing.mResetSamples + 10 : 20;
+        appendLedEdges(timing, controller.mBitsPerChannel, controller.mLayout, rgb, firstLowSamples, edges);
+    }
+    std::vector<U32> pulses;
+    for (size_t e = 1; e < edges.size(); ++e) {
+        pulses.push_back(static_cast<U32>(edges[e] - edges[e - 1]));
+    }
+    pulses.push_back(static_cast<U32>(timing.mResetSamples + 1));
+    TEST_VERIFY_EQ(pulses.size(), 3 * 48);
+
+    // small blocks, so packets span several
+    LazyPacketStore store(16);
+    store.Clear(timing, controller.mBitsPerChannel, controller.mLayout, 2);
+
+    // a packet of the last LED, added in blocks of any size
+    const U32* lastLed = pulses.data() + 2 * 48;
+    store.AppendPulses(lastLed, 5);
+    store.AppendPulses(lastLed + 5, 43);
+    TEST_VERIFY_EQ(store.OpenPacketLedCount(), 1);
+    TEST_VERIFY(!store.IsOpenPacketTruncated());
+    TEST_VERIFY_EQ(store.EndPacket(), 0);
+
+    // data pulses take one byte at this sample rate, and the reset two
+    TEST_VERIFY_EQ(store.StoredBytes(), 49);
+
+    // a packet longer than the limit keeps its first LEDs
+    store.AppendPulses(pulses.data(), pulses.size());
+    TEST_VERIFY_EQ(store.OpenPacketLedCount(), 2);
+    TEST_VERIFY(store.IsOpenPacketTruncated());
+    TEST_VERIFY_EQ(store.EndPacket(), 1);
+    TEST_VERIFY_EQ(store.StoredBytes(), 49 + 2 * 48);
+
+    // a packet without any LED is dropped
+    store.AppendPulses(pulses.data(), 10);
+    store.DiscardPacket();
+    TEST_VERIFY_EQ(store.PacketCount(), 2);
+    TEST_VERIFY_EQ(store.StoredBytes(), 49 + 2 * 48);
+
+    RGBValue decoded[3];
+    TEST_VERIFY_EQ(store.GetColors(0, 0, 3, decoded), 1);
+    TEST_VERIFY_EQ(decoded[0].ConvertToU64(), colors[2].ConvertToU64());
+    TEST_VERIFY_EQ(store.GetColors(1, 0, 3, decoded), 2);
+    TEST_VERIFY_EQ(decoded[0].ConvertToU64(), colors[0].ConvertToU64());
+    TEST_VERIFY_EQ(decoded[1].ConvertToU64(), colors[1].ConvertToU64());
+    TEST_VERIFY_EQ(store.GetColors(1, 1, 3, decoded), 1);
+    TEST_VERIFY_EQ(decoded[0].ConvertToU64(), colors[1].ConvertToU64());
+    TEST_VERIFY_EQ(store.GetColors(2, 0, 3, decoded), 0);
+
+    // readers decode on their own, so they can be interleaved and used on
+    // several threads at once
+    const std::vector<std::vector<RGBValue>> expected{{colors[2]}, {colors[0], colors[1]}, {colors[2]}};
+    LazyPacketStore::Reader first(store);
+    LazyPacketStore::Reader second(store);
+    verifyPacketColors(first, 0, expected[0]);
+    verifyPacketColors(second, 1, expected[1]);
+    verifyPacketColors(first, 1, expected[1]);
+    verifyPacketColors(second, 0, expected[0]);
+    TEST_VERIFY_EQ(first.GetColors(2, 0, 3, decoded), 0);
+
+    // the background thread decodes the packets stored, and those added later
+    store.StartBackgroundDecode();
+    store.AppendPulses(lastLed, 48);
+    store.EndPacket();
+    for (int wait = 0; (wait < 1000) && (store.BackgroundDecodedCount() < 3); ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    TEST_VERIFY_EQ(store.BackgroundDecodedCount(), 3);
+
+    // only the block holding the end of the last packet is left
+    TEST_VERIFY_EQ(store.StoredBytes(), (49 + 2 * 48 + 49) % 16);
+    TEST_VERIFY_EQ(store.GetColors(1, 0, 3, decoded), 2);
+    TEST_VERIFY_EQ(decoded[1].ConvertToU64(), colors[1].ConvertToU64());
+    TEST_VERIFY_EQ(store.GetColors(2, 0, 3, decoded), 1);
+    TEST_VERIFY_EQ(decoded[0].ConvertToU64(), colors[2].ConvertToU64());
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&store, &expected]() {
+            LazyPacketStore::Reader reader(store);
+            for (U32 p = 0; p < expected.size(); ++p) {
+                verifyPacketColors(reader, p, expected[p]);
+            }
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    // packets added after the freed blocks start in a new block
+    store.AppendPulses(pulses.data(), 2 * 48);
+    store.EndPacket();
+    for (int wait = 0; (wait < 1000) && (store.BackgroundDecodedCount() < 4); ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    TEST_VERIFY_EQ(store.BackgroundDecodedCount(), 4);
+    verifyPacketColors(store, 3, expected[1]);
+    store.AppendPulses(pulses.data(), 10);
+    store.DiscardPacket();
+    store.AppendPulses(lastLed, 48);
+    store.EndPacket();
+    verifyPacketColors(store, 4, expected[0]);
+
+    // clearing stops the thread
+    store.Clear(timing, controller.mBitsPerChannel, controller.mLayout);
+    TEST_VERIFY_EQ(store.BackgroundDecodedCount(), 0);
+
+    std::cout << "passed test: lazy packet store" << std::endl;
+}
+
+void testCApi()
+{
+    TEST_VERIFY_EQ(asyncrgbled_controller_count(), LED_CONTROLLER_COUNT);
+    TEST_VERIFY_EQ_CHARS(asyncrgbled_controller_name(AsyncRgbLedAnalyzerSettings::LED_WS2812B), "WS2812B");
+    TEST_VERIFY(asyncrgbled_controller_name(LED_CONTROLLER_COUNT) == nullptr);
+    TEST_VERIFY(asyncrgbled_create(LED_CONTROLLER_COUNT, 20000000) == nullptr);
+    TEST_VERIFY(asyncrgbled_create(AsyncRgbLedAnalyzerSettings::LED_WS2812B, 0) == nullptr);
+
+    const U32 sampleRateHz = 20000000;
+    const LedControllerData& controller = GetLedControllerData(AsyncRgbLedAnalyzerSettings::LED_WS2812B);
+    const DecoderTiming timing = CreateDecoderTiming(controller, sampleRateHz);
+    const U64 resetSamples = timing.mResetSamples + 10;
+
+    std::vector<U64> edges;
+    appendLedEdges(timing, controller.mBitsPerChannel, controller.mLayout, makeRGB(0x12, 0x34, 0x56), resetSamples, edges);
+    appendLedEdges(timing, controller.mBitsPerChannel, controller.mLayout, makeRGB(0xff, 0x00, 0x80), 20, edges);
+    appendLedEdges(timing, controller.mBitsPerChannel, controller.mLayout, makeRGB(0x01, 0x02, 0x03), resetSamples, edges);
+    const U64 idleSample = edges.back() + resetSamples;
+    const std::vector<uint64_t> rawEdges(edges.begin(), edges.end());
+
+    AsyncRgbLedDecoder* decoder = asyncrgbled_create(AsyncRgbLedAnalyzerSettings::LED_WS2812B, sampleRateHz);
+    TEST_VERIFY(decoder != nullptr);
+
+    std::vector<AsyncRgbLedRecord> records(asyncrgbled_max_records(decoder, edges.size()));
+    TEST_VERIFY_EQ(records.size(), 3);
+
+    size_t recordCount = 0;
+    TEST_VERIFY_EQ(asyncrgbled_decode(decoder, rawEdges.data(), rawEdges.size(), idleSample,
+                                      records.data(), records.size(), &recordCount), ASYNCRGBLED_OK);
+    TEST_VERIFY_EQ(recordCount, 3);
+    TEST_VERIFY_EQ(records[0].packet, 0);
+    TEST_VERIFY_EQ(records[0].index, 0);
+    TEST_VERIFY_EQ(records[0].red, 0x12);
+    TEST_VERIFY_EQ(records[0].green, 0x34);
+    TEST_VERIFY_EQ(records[0].blue, 0x56);
+    TEST_VERIFY_EQ(records[0].start_sample, edges[0]);
+    TEST_VERIFY_EQ(records[1].packet, 0);
+    TEST_VERIFY_EQ(records[1].index, 1);
+    TEST_VERIFY_EQ(records[1].red, 0xff);
+    TEST_VERIFY_EQ(records[2].packet, 1);
+    TEST_VERIFY_EQ(records[2].index, 0);
+    TEST_VERIFY_EQ(records[2].blue, 0x03);
+
+    // each call decodes from scratch, and stops filling a full array
+    TEST_VERIFY_EQ(asyncrgbled_decode(decoder, rawEdges.data(), rawEdges.size(), idleSample,
+                                      records.data(), 1, &recordCount), ASYNCRGBLED_ERROR_OUTPUT_FULL);
+    TEST_VERIFY_EQ(recordCount, 1);
+    TEST_VERIFY_EQ(records[0].green, 0x34);
+
+    // without the idle period, the last packet isn't finished
+    TEST_VERIFY_EQ(asyncrgbled_decode(decoder, rawEdges.data(), rawEdges.size(), edges.back(),
+                                      records.data(), records.size(), &recordCount), ASYNCRGBLED_OK);
+    TEST_VERIFY_EQ(recordCount, 2);
+
+    TEST_VERIFY_EQ(asyncrgbled_decode(decoder, rawEdges.data(), rawEdges.size(), idleSample,
+                                      records.data(), records.size(), nullptr), ASYNCRGBLED_ERROR_ARGUMENT);
+
+    asyncrgbled_destroy(decoder);
+    std::cout << "passed test: C API" << std::endl;
+}
+
+void testRunLengthMode()
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    analyzeText(pluginInstance, channelData, "WS2812B", WS2812B,
+                "reset,"
+                "#000000,#000000,#000000,#000000,#000000,#ff0000,#000000,#000000_reset,"
+                "#000000,#000000_reset",
+                [](AsyncRgbLedAnalyzerSettings* settings) {
+        settings->mResultsMode = AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH;
+    });
+
+    // runs never continue across a packet boundary
+    auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
+    TEST_VERIFY_EQ(results->TotalFrameCount(), 4);
+    TEST_VERIFY_EQ(results->GetFrame(0).mFlags, FRAME_FLAG_RUN);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(0).mData2), 0);
+    TEST_VERIFY_EQ(FrameLastLedIndex(results->GetFrame(0).mData2), 4);
+    TEST_VERIFY_EQ(results->GetFrame(1).mFlags, 0);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(1).mData2), 5);
+    TEST_VERIFY_EQ(results->GetFrame(1).mData1, rgb_triple_as_u64(0xff, 0, 0));
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(2).mData2), 6);
+    TEST_VERIFY_EQ(FrameLastLedIndex(results->GetFrame(2).mData2), 7);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(3).mData2), 0);
+    TEST_VERIFY_EQ(FrameLastLedIndex(results->GetFrame(3).mData2), 1);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(3)), 1);
+
+    pluginInstance.GenerateBubbleText(0, TEST_CHANNEL, Decimal);
+    TEST_VERIFY_EQ(results->GetString(0), "LED 0-4 Red: 0 Green: 0 Blue: 0 #000000");
+    TEST_VERIFY_EQ(results->GetString(2), "(0-4) #000000");
+
+    pluginInstance.GenerateTabularText(2, Decimal);
+    TEST_VERIFY_EQ(results->GetTabularText(0), "[6-7] 0, 0, 0");
+
+    // export expands the runs back into LEDs
+    const auto exportLines = exportTextLines(pluginInstance, Decimal);
+
+    TEST_VERIFY_EQ(exportLines.size(), 11);
+    TEST_VERIFY_EQ(exportLines.at(5).substr(exportLines.at(5).find(',')), ",0,4,0,0,0,#000000");
+    TEST_VERIFY_EQ(exportLines.at(6).substr(exportLines.at(6).find(',')), ",0,5,255,0,0,#ff0000");
+    TEST_VERIFY_EQ(exportLines.at(10).substr(exportLines.at(10).find(',')), ",1,1,0,0,0,#000000");
+
+    std::cout << "passed test: run-length mode" << std::endl;
+}
+
+void testHighSpeedFrameFlag()
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    MockChannelData channelData(&pluginInstance);
+    analyzeText(pluginInstance, channelData, "WS2811", WS2811_high_speed,
+                "reset,#abbade,#223344_reset,#aaddcc_reset");
+
+    auto results = MockResultData::MockFromResults(pluginInstance.GetResults());
+    TEST_VERIFY_EQ(results->TotalFrameCount(), 3);
+    TEST_VERIFY_EQ(results->GetFrame(0).mFlags, FRAME_FLAG_HIGH_SPEED);
+    TEST_VERIFY_EQ(results->GetFrame(2).mFlags, FRAME_FLAG_HIGH_SPEED);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(1)), 0);
+    TEST_VERIFY_EQ(framePacketSequence(results->GetFrame(2)), 1);
+
+    std::cout << "passed test: high-speed frame flag" << std::endl;
+}
+
 void testSettings()
 {
     Instance pluginInstance{"Addressable LEDs (Async)"};
@@ -401,7 +1659,7 @@ void testSettings()
     TEST_VERIFY_EQ(mock->mChannels.at(0).used, false);
 
     // check which settings were defined
-    TEST_VERIFY_EQ(mock->mInterfaces.size(), 2);
+    TEST_VERIFY_EQ(mock->mInterfaces.size(), 12);
 
     auto channelSetting = mock->mInterfaces.at(0);
     TEST_VERIFY_EQ(channelSetting->GetType(), INTERFACE_CHANNEL);
@@ -411,6 +1669,58 @@ void testSettings()
     auto controllerSettingMock = MockSettingInterface::MockFromInterface(setting);
 
     TEST_VERIFY_EQ_CHARS(setting->GetTitle(), "LED Controller");
+
+    auto resultsModeSetting = mock->mInterfaces.at(2);
+    TEST_VERIFY_EQ(resultsModeSetting->GetType(), INTERFACE_NUMBER_LIST);
+    TEST_VERIFY_EQ_CHARS(resultsModeSetting->GetTitle(), "Results Mode");
+
+    // export window, where empty text means no limit
+    auto ledSettings = static_cast<AsyncRgbLedAnalyzerSettings*>(pluginInstance.GetSettings());
+    TEST_VERIFY_EQ(mock->GetSetting("Export Last LED")->integer, AsyncRgbLedAnalyzerSettings::MAX_EXPORT_LED);
+    mock->GetSetting("Export From [s]")->text = " 12.5 ";
+    TEST_VERIFY(ledSettings->SetSettingsFromInterfaces());
+    TEST_VERIFY(ledSettings->mHasExportStart);
+    TEST_VERIFY_EQ(ledSettings->mExportStartSec, 12.5);
+    TEST_VERIFY(!ledSettings->mHasExportEnd);
+
+    mock->GetSetting("Export To [s]")->text = "soon";
+    TEST_VERIFY(!ledSettings->SetSettingsFromInterfaces());
+    mock->GetSetting("Export To [s]")->text = "";
+    mock->GetSetting("Export First LED")->integer = 10;
+    mock->GetSetting("Export Last LED")->integer = 9;
+    TEST_VERIFY(!ledSettings->SetSettingsFromInterfaces());
+
+    mock->GetSetting("Export Last LED")->integer = 10;
+    mock->GetSetting("Decode Threads")->integer = 8;
+    TEST_VERIFY(ledSettings->SetSettingsFromInterfaces());
+    TEST_VERIFY_EQ(ledSettings->mDecodeThreadCount, 8);
+
+    // commit policy, where the interval has to be a number of seconds
+    TEST_VERIFY_EQ(mock->GetSetting("Commit Every N Frames")->integer, 256);
+    TEST_VERIFY_EQ(std::strtod(mock->GetSetting("Commit Interval [s]")->text.c_str(), nullptr), 0.01);
+    mock->GetSetting("Commit Every N Frames")->integer = 64;
+    mock->GetSetting("Commit Interval [s]")->text = "0.5";
+    TEST_VERIFY(ledSettings->SetSettingsFromInterfaces());
+    TEST_VERIFY_EQ(ledSettings->mCommitFrameCount, 64);
+    TEST_VERIFY_EQ(ledSettings->mCommitIntervalSec, 0.5);
+    for (const char* badInterval : {"", "-1", "61", "often"}) {
+        mock->GetSetting("Commit Interval [s]")->text = badInterval;
+        TEST_VERIFY(!ledSettings->SetSettingsFromInterfaces());
+    }
+    mock->GetSetting("Commit Interval [s]")->text = "0.01";
+    mock->GetSetting("Commit Every N Frames")->integer = 0;
+    TEST_VERIFY(!ledSettings->SetSettingsFromInterfaces());
+    mock->GetSetting("Commit Every N Frames")->integer = 256;
+
+    TEST_VERIFY_EQ(ledSettings->mLiveLatencyMs, 0);
+    mock->GetSetting("Live Latency [ms]")->integer = 5;
+    TEST_VERIFY(ledSettings->SetSettingsFromInterfaces());
+    TEST_VERIFY_EQ(ledSettings->mLiveLatencyMs, 5);
+
+    TEST_VERIFY_EQ(ledSettings->mEdgeCacheMiB, AsyncRgbLedAnalyzerSettings::DEFAULT_EDGE_CACHE_MIB);
+    mock->GetSetting("Edge Cache [MiB]")->integer = 0;
+    TEST_VERIFY(ledSettings->SetSettingsFromInterfaces());
+    TEST_VERIFY_EQ(ledSettings->mEdgeCacheMiB, 0);
 }
 
 void testLoadSettings()
@@ -456,9 +1766,9 @@ void testSynchronizeMidData(const std::string& controller,
     TEST_VERIFY_EQ(results->TotalPacketCount(), 3); // FIXME, analyzer is appending an empty packet
 
     // verify LED indices between reset pulses
-    TEST_VERIFY_EQ(results->GetFrame(1).mData2, 1);
-    TEST_VERIFY_EQ(results->GetFrame(5).mData2, 5);
-    TEST_VERIFY_EQ(results->GetFrame(6).mData2, 0);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(1).mData2), 1);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(5).mData2), 5);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(6).mData2), 0);
 
     TEST_VERIFY_EQ(results->GetFrame(0).mData1, rgb_triple_as_u64(0xaa, 0xbb, 0xcc));
     TEST_VERIFY_EQ(results->GetFrame(3).mData1, rgb_triple_as_u64(0x99, 0x88, 0x77));
@@ -502,12 +1812,12 @@ void testResynchronizeAfterBadData(const std::string& controller,
     TEST_VERIFY_EQ(results->TotalPacketCount(), 4); // FIXME, analyzer is appending an empty packet
 
     // verify LED indices between reset pulses
-    TEST_VERIFY_EQ(results->GetFrame(1).mData2, 1);
-    TEST_VERIFY_EQ(results->GetFrame(4).mData2, 0);
-    TEST_VERIFY_EQ(results->GetFrame(5).mData2, 1);
-    TEST_VERIFY_EQ(results->GetFrame(6).mData2, 0);
-    TEST_VERIFY_EQ(results->GetFrame(7).mData2, 1);
-    TEST_VERIFY_EQ(results->GetFrame(11).mData2, 5);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(1).mData2), 1);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(4).mData2), 0);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(5).mData2), 1);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(6).mData2), 0);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(7).mData2), 1);
+    TEST_VERIFY_EQ(FrameLedIndex(results->GetFrame(11).mData2), 5);
 
     TEST_VERIFY_EQ(results->GetFrame(0).mData1, rgb_triple_as_u64(0xaa, 0xbb, 0xcc));
     TEST_VERIFY_EQ(results->GetFrame(4).mData1, rgb_triple_as_u64(0xaa, 0xbb, 0xcc));
@@ -521,15 +1831,15 @@ void testResynchronizeAfterBadData(const std::string& controller,
     std::cout << "passed test: re-synchronize after bad data mid-stream; for " << controller << std::endl;
 }
 
-struct BitTiming {
+struct NominalBitTiming {
     double highSec;
     double lowSec;
 };
 
 struct ModeTiming
 {
-    BitTiming zeroTiming;
-    BitTiming oneTiming;
+    NominalBitTiming zeroTiming;
+    NominalBitTiming oneTiming;
 };
 
 void verifyReset(SimulatedChannel* sim_chan,
@@ -546,7 +1856,7 @@ void verifyReset(SimulatedChannel* sim_chan,
  * @param epsilon
  * @return
  */
-bool canClassify(const BitTiming& timing, double hiSec, double lowSec, double epsilon)
+bool canClassify(const NominalBitTiming& timing, double hiSec, double lowSec, double epsilon)
 {
     return std::fabs(timing.highSec - hiSec) < epsilon &&
             std::fabs(timing.lowSec - lowSec) < epsilon;
@@ -681,6 +1991,248 @@ void testSimulationData1()
     std::cout << "did parse simulation data" << std::endl;
 }
 
+U8 expectedPulseClass(const TimingTolerance& lowBit, const TimingTolerance& highBit,
+                      U64 samples, double sampleRateHz)
+{
+    const double halfSampleWidth = 0.5 / sampleRateHz;
+    const double t = samples / sampleRateHz;
+    U8 result = PULSE_INVALID;
+    if (lowBit.WithinTolerance(t, halfSampleWidth)) {
+        result |= PULSE_BIT_LOW;
+    }
+
+    if (highBit.WithinTolerance(t, halfSampleWidth)) {
+        result |= PULSE_BIT_HIGH;
+    }
+
+    return result;
+}
+
+void testPulseClassifierTables()
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    auto settings = static_cast<AsyncRgbLedAnalyzerSettings*>(pluginInstance.GetSettings());
+
+    for (const double sampleRateHz : {12e6, 40e6, 100e6, 500e6}) {
+        for (int c = AsyncRgbLedAnalyzerSettings::LED_WS2811; c <= AsyncRgbLedAnalyzerSettings::LED_LPD1886_12bit; ++c) {
+            settings->mLEDController = static_cast<AsyncRgbLedAnalyzerSettings::Controller>(c);
+            const DecoderTiming timing = settings->SampleTiming(sampleRateHz);
+            TEST_VERIFY_EQ(timing.mHasHighSpeed, settings->IsHighSpeedSupported());
+
+            for (const bool isHighSpeed : {false, true}) {
+                if (isHighSpeed && !settings->IsHighSpeedSupported()) {
+                    continue;
+                }
+
+                const PulseClassifier& classifier = timing.Classifier(isHighSpeed);
+                const BitTiming lowBit = settings->DataTiming(BIT_LOW, isHighSpeed);
+                const BitTiming highBit = settings->DataTiming(BIT_HIGH, isHighSpeed);
+
+                // go past the end of the tables, to check the clamping
+                for (U64 s = 0; s < classifier.mPositive.size() + 16; ++s) {
+                    TEST_VERIFY_EQ(classifier.ClassifyPositive(s),
+                                   expectedPulseClass(lowBit.mPositiveTiming, highBit.mPositiveTiming, s, sampleRateHz));
+                }
+
+                for (U64 s = 0; s < classifier.mNegative.size() + 16; ++s) {
+                    TEST_VERIFY_EQ(classifier.ClassifyNegative(s),
+                                   expectedPulseClass(lowBit.mNegativeTiming, highBit.mNegativeTiming, s, sampleRateHz));
+                }
+            }
+        }
+    }
+
+    std::cout << "passed test: pulse classifier tables" << std::endl;
+}
+
+// the bit-by-bit decision made by ReadBit, once the speed mode is known
+bool referenceClassify(const DecoderTiming& timing, bool isHighSpeed,
+                       U64 positive, U64 negative, BitState* value)
+{
+    const PulseClassifier& classifier = timing.Classifier(isHighSpeed);
+    const U8 positiveClass = classifier.ClassifyPositive(positive);
+    if (positiveClass == PULSE_INVALID) {
+        return false;
+    }
+
+    *value = (positiveClass & PULSE_BIT_LOW) ? BIT_LOW : BIT_HIGH;
+    if ((negative <= timing.mTooShortLowSamples) || (negative > timing.mResetSamples)) {
+        return false;
+    }
+
+    return (classifier.ClassifyNegative(negative) & PulseClassFor(*value)) != 0;
+}
+
+void addLimits(std::vector<U32>& values, U64 minimum, U64 maximum)
+{
+    for (const U64 v : {minimum, maximum}) {
+        values.push_back(static_cast<U32>(std::min<U64>(v, 0xFFFFFFFF)));
+        values.push_back(static_cast<U32>(std::min<U64>(v + 1, 0xFFFFFFFF)));
+        if (v > 0) {
+            values.push_back(static_cast<U32>(std::min<U64>(v - 1, 0xFFFFFFFF)));
+        }
+    }
+}
+
+void testBatchClassifiers()
+{
+    Instance pluginInstance{"Addressable LEDs (Async)"};
+    auto settings = static_cast<AsyncRgbLedAnalyzerSettings*>(pluginInstance.GetSettings());
+    const std::vector<BatchClassifier> classifiers = SupportedBatchClassifiers();
+    TEST_VERIFY_EQ_CHARS(classifiers.front().mName, "scalar");
+
+    for (int c = AsyncRgbLedAnalyzerSettings::LED_WS2811; c <= AsyncRgbLedAnalyzerSettings::LED_LPD1886_12bit; ++c) {
+        settings->mLEDController = static_cast<AsyncRgbLedAnalyzerSettings::Controller>(c);
+        const DecoderTiming timing = settings->SampleTiming(40e6);
+
+        for (const bool isHighSpeed : {false, true}) {
+            if (isHighSpeed && !timing.mHasHighSpeed) {
+                continue;
+            }
+
+            const BatchThresholds thresholds = BatchThresholds::Create(timing, isHighSpeed);
+
+            // pulse lengths on and around every limit, plus some extremes
+            std::vector<U32> candidates = {0, 1, 0x7fffffff, 0x80000000, 0xffffffff};
+            for (const auto b : {BIT_LOW, BIT_HIGH}) {
+                const BitSampleTiming& bit = timing.DataTiming(b, isHighSpeed);
+                addLimits(candidates, bit.mPositive.mMinimum, bit.mPositive.mMaximum);
+                addLimits(candidates, bit.mNegative.mMinimum, bit.mNegative.mMaximum);
+            }
+            addLimits(candidates, timing.mTooShortLowSamples, timing.mResetSamples);
+
+            for (int iteration = 0; iteration < 500; ++iteration) {
+                U32 positive[MAX_BATCH_PULSES], negative[MAX_BATCH_PULSES];
+                for (size_t i = 0; i < MAX_BATCH_PULSES; ++i) {
+                    positive[i] = candidates.at(rand() % candidates.size());
+                    negative[i] = candidates.at(rand() % candidates.size());
+                }
+
+                for (const size_t count : {size_t(64), size_t(37), size_t(24), size_t(3)}) {
+                    U64 expectedBits = 0, expectedValid = 0;
+                    for (size_t i = 0; i < count; ++i) {
+                        BitState value = BIT_LOW;
+                        if (referenceClassify(timing, isHighSpeed, positive[i], negative[i], &value)) {
+                            expectedValid |= U64(1) << i;
+                            expectedBits |= U64(value) << i;
+                        }
+                    }
+
+                    for (const BatchClassifier& classifier : classifiers) {
+                        U64 bits = 0, valid = 0;
+                        classifier.mClassify(positive, negative, count, thresholds, &bits, &valid);
+                        TEST_VERIFY_EQ(valid, expectedValid);
+                        TEST_VERIFY_EQ(bits & valid, expectedBits);
+                    }
+                }
+            }
+        }
+    }
+
+    // word packing, for both channel sizes
+    for (const U8 bitSize : {U8(8), U8(12)}) {
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            const U16 mask = (1 << bitSize) - 1;
+            const U16 words[3] = {U16(rand() & mask), U16(rand() & mask), U16(rand() & mask)};
+
+            // pulse order is MSB first, word by word
+            U64 bits = 0;
+            int pulse = 0;
+            for (const U16 w : words) {
+                for (int b = bitSize - 1; b >= 0; --b) {
+                    bits |= U64((w >> b) & 1) << pulse++;
+                }
+            }
+
+            U16 packed[3];
+            PackChannelWords(bits, bitSize, packed);
+            TEST_VERIFY_EQ(packed[0], words[0]);
+            TEST_VERIFY_EQ(packed[1], words[1]);
+            TEST_VERIFY_EQ(packed[2], words[2]);
+        }
+    }
+
+    std::cout << "passed test: batch classifiers (" << classifiers.size() << " implementations)" << std::endl;
+}
+
+void testEdgeScanners()
+{
+    const std::vector<EdgeScanner> scanners = SupportedEdgeScanners();
+    TEST_VERIFY_EQ_CHARS(scanners.front().mName, "scalar");
+
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        // runs of random lengths, from single samples to many idle words,
+        // and a length which usually leaves a partial last word
+        const U64 sampleCount = 1 + rand() % 20000;
+        std::vector<U8> data((sampleCount + 7) / 8, 0);
+        std::vector<U64> expected;
+        BitState level = (rand() % 2) ? BIT_HIGH : BIT_LOW;
+
+        for (U64 sample = 0; sample < sampleCount; ) {
+            const U64 run = (rand() % 4 == 0) ? 1 + rand() % 1000 : 1 + rand() % 8;
+            for (U64 i = sample; i < std::min(sample + run, sampleCount); ++i) {
+                if (level == BIT_HIGH) {
+                    data[i / 8] |= U8(1 << (i % 8));
+                }
+            }
+
+            sample += run;
+            if (sample < sampleCount) {
+                expected.push_back(sample);
+                level = (level == BIT_HIGH) ? BIT_LOW : BIT_HIGH;
+            }
+        }
+
+        for (const EdgeScanner& scanner : scanners) {
+            for (const size_t chunkSize : {PACKED_WORD_SAMPLES, size_t(1000)}) {
+                PackedEdgeScanner packed(data.data(), sampleCount, scanner.mScan);
+                TEST_VERIFY_EQ(packed.InitialLevel(), (data[0] & 1) ? BIT_HIGH : BIT_LOW);
+
+                std::vector<U64> edges;
+                std::vector<U64> chunk(chunkSize);
+                for (size_t count = packed.Next(chunk.data(), chunkSize); count > 0;
+                        count = packed.Next(chunk.data(), chunkSize)) {
+                    edges.insert(edges.end(), chunk.begin(), chunk.begin() + count);
+                }
+
+                TEST_VERIFY(edges == expected);
+            }
+        }
+    }
+
+    std::cout << "passed test: bitstream edge scanners (" << scanners.size() << " implementations)" << std::endl;
+}
+
+void testExportBuffer()
+{
+    std::ostringstream os;
+
+    {
+        // small capacity, so values straddle the flushes
+        ExportBuffer out(os, 64);
+        out.AppendDecimal(0);
+        out.Append(',');
+        out.AppendDecimal(18446744073709551615ULL);
+        out.Append(',');
+        out.AppendHex(0x1a, 8);
+        out.Append(',');
+        out.AppendHex(0xabc, 12);
+        out.Append(',');
+        out.AppendTime(1500, 1000, 40000000);
+        out.Append(',');
+        out.AppendTime(1000, 40001001, 40000000);
+        out.Append(',');
+        const U8 color[3] = {0x0f, 0xa0, 0xff};
+        out.AppendWebColor(color);
+        out.Append("\nlonger than the whole buffer");
+    }
+
+    TEST_VERIFY_EQ(os.str(), "0,18446744073709551615,0x1A,0xABC,0.000012500,-1.000000025,#0fa0ff\n"
+                             "longer than the whole buffer");
+
+    std::cout << "passed test: export buffer" << std::endl;
+}
+
 void runTests(const std::string& name,
               const LedChannelDataGenerator::ModeTiming& timing)
 {
@@ -704,6 +2256,38 @@ int main(int argc, char* argv[])
 {
     testSettings();
     testSimulationData1();
+    testPulseClassifierTables();
+    testBatchClassifiers();
+    testEdgeScanners();
+    testEdgeCache();
+    testCommitPolicy();
+    testLiveLagTracker();
+    testExportBuffer();
+    testColorArena();
+    testPacketIndex();
+    testTextCache();
+    testFilteredExport(AsyncRgbLedAnalyzerSettings::RESULTS_PER_LED);
+    testFilteredExport(AsyncRgbLedAnalyzerSettings::RESULTS_PER_PACKET);
+    testFilteredExport(AsyncRgbLedAnalyzerSettings::RESULTS_RUN_LENGTH);
+    testPacketMode();
+    testRunLengthMode();
+    testTimelineMode("WS2811", WS2811_normal_speed, false);
+    testTimelineMode("WS2811", WS2811_high_speed, true);
+    testTimelineMode("WS2812B", WS2812B, false);
+    testHighSpeedFrameFlag();
+    testParallelDecode("WS2811", WS2811_normal_speed);
+    testParallelDecode("WS2811", WS2811_high_speed);
+    testParallelDecode("WS2812B", WS2812B);
+    testParallelDecode("TM1809", TM1809_high_speed);
+    testParallelLongSegments();
+    testParallelCaptureEnd();
+    testReanalysisFromCache();
+    testLiveMode();
+    testDecoderPush("WS2811");
+    testDecoderPush("WS2812B");
+    testDecoderPush("UCS1903");
+    testLazyPacketStore();
+    testCApi();
 
     runTests("WS2811", WS2811_normal_speed);
     runTests("WS2811", WS2811_high_speed);
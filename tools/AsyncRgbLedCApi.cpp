@@ -0,0 +1,145 @@
+#include "AsyncRgbLedCApi.h"
+
+#include <cstddef> // for offsetof
+#include <memory>
+#include <new>
+
+#include "AsyncRgbLedControllers.h"
+#include "AsyncRgbLedDecoder.h"
+#include "AsyncRgbLedExport.h"
+
+// records can be written straight to a binary export, or read from one
+static_assert( sizeof( AsyncRgbLedRecord ) == sizeof( BinaryExportRecord ), "record layout differs from the binary export" );
+static_assert( offsetof( AsyncRgbLedRecord, packet ) == offsetof( BinaryExportRecord, mPacketId ), "record layout differs from the binary export" );
+static_assert( offsetof( AsyncRgbLedRecord, red ) == offsetof( BinaryExportRecord, mRed ), "record layout differs from the binary export" );
+
+/// the decoder for one controller and sample rate, writing to the caller's records
+struct AsyncRgbLedDecoder : public DecoderOutput
+{
+    void StartPacket() override
+    {
+        ++mPacketSequence;
+        mLedIndex = 0;
+    }
+
+    void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool ) override
+    {
+        const U32 ledIndex = mLedIndex++;
+
+        if ( mRecordCount == mMaxRecords )
+        {
+            mIsOutputFull = true;
+            return;
+        }
+
+        AsyncRgbLedRecord& record = mRecords[mRecordCount++];
+        record.start_sample = beginSample;
+        record.end_sample = endSample;
+        record.packet = mPacketSequence - 1;
+        record.index = ledIndex;
+        record.red = rgb.red;
+        record.green = rgb.green;
+        record.blue = rgb.blue;
+        record.reserved = 0;
+    }
+
+    void EndPacket( bool, U64 ) override
+    {
+    }
+
+    std::unique_ptr<LedDecoder> mDecoder;
+    U8 mBitSize = 0;
+
+    // output of the current call
+    AsyncRgbLedRecord* mRecords = nullptr;
+    size_t mMaxRecords = 0;
+    size_t mRecordCount = 0;
+    bool mIsOutputFull = false;
+    U32 mPacketSequence = 0;
+    U32 mLedIndex = 0;
+};
+
+size_t asyncrgbled_controller_count( void )
+{
+    return LED_CONTROLLER_COUNT;
+}
+
+const char* asyncrgbled_controller_name( size_t controller )
+{
+    return ( controller < LED_CONTROLLER_COUNT ) ? GetLedControllerData( controller ).mName : nullptr;
+}
+
+AsyncRgbLedDecoder* asyncrgbled_create( size_t controller, uint32_t sample_rate_hz )
+{
+    if ( ( controller >= LED_CONTROLLER_COUNT ) || ( sample_rate_hz == 0 ) )
+    {
+        return nullptr;
+    }
+
+    const LedControllerData& data = GetLedControllerData( controller );
+    std::unique_ptr<AsyncRgbLedDecoder> decoder( new ( std::nothrow ) AsyncRgbLedDecoder );
+
+    if ( !decoder )
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        decoder->mDecoder = LedDecoder::Create( CreateDecoderTiming( data, sample_rate_hz ), data.mBitsPerChannel, data.mLayout );
+    }
+    catch ( const std::bad_alloc& )
+    {
+        return nullptr;
+    }
+
+    decoder->mBitSize = data.mBitsPerChannel;
+    return decoder.release();
+}
+
+void asyncrgbled_destroy( AsyncRgbLedDecoder* decoder )
+{
+    delete decoder;
+}
+
+size_t asyncrgbled_max_records( const AsyncRgbLedDecoder* decoder, size_t edge_count )
+{
+    // every LED has a rising and a falling edge for each of its bits
+    return ( decoder != nullptr ) ? edge_count / ( 2 * 3 * decoder->mBitSize ) : 0;
+}
+
+int asyncrgbled_decode( AsyncRgbLedDecoder* decoder,
+                        const uint64_t* edges, size_t edge_count, uint64_t idle_sample,
+                        AsyncRgbLedRecord* records, size_t max_records, size_t* record_count )
+{
+    if ( ( decoder == nullptr ) || ( record_count == nullptr ) ||
+            ( ( edges == nullptr ) && ( edge_count > 0 ) ) || ( ( records == nullptr ) && ( max_records > 0 ) ) )
+    {
+        return ASYNCRGBLED_ERROR_ARGUMENT;
+    }
+
+    for ( size_t i = 1; i < edge_count; ++i )
+    {
+        if ( edges[i] < edges[i - 1] )
+        {
+            return ASYNCRGBLED_ERROR_ARGUMENT;
+        }
+    }
+
+    decoder->mRecords = records;
+    decoder->mMaxRecords = max_records;
+    decoder->mRecordCount = 0;
+    decoder->mIsOutputFull = false;
+    decoder->mPacketSequence = 0;
+
+    decoder->mDecoder->Start( 0, decoder );
+    // uint64_t and U64 can be different types of the same size
+    static_assert( sizeof( uint64_t ) == sizeof( U64 ), "edge sample numbers need 64 bits" );
+    decoder->mDecoder->Push( reinterpret_cast<const U64*>( edges ), edge_count );
+
+    decoder->mDecoder->Idle( idle_sample );
+
+    *record_count = decoder->mRecordCount;
+    decoder->mRecords = nullptr;
+    return decoder->mIsOutputFull ? ASYNCRGBLED_ERROR_OUTPUT_FULL : ASYNCRGBLED_OK;
+}
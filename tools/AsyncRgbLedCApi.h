@@ -0,0 +1,79 @@
+#ifndef ASYNCRGBLED_C_API
+#define ASYNCRGBLED_C_API
+
+/*
+ * C interface to the LED decoder, for decoding edge buffers in memory from
+ * other languages. Nothing is allocated after asyncrgbled_create(), so
+ * buffers owned by the caller, such as numpy arrays, are used in place.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+    #if defined(ASYNCRGBLED_API_BUILD)
+        #define ASYNCRGBLED_API __declspec(dllexport)
+    #else
+        #define ASYNCRGBLED_API __declspec(dllimport)
+    #endif
+#else
+    #define ASYNCRGBLED_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* return codes */
+#define ASYNCRGBLED_OK 0
+#define ASYNCRGBLED_ERROR_ARGUMENT 1
+/* records were left out because the record array was full */
+#define ASYNCRGBLED_ERROR_OUTPUT_FULL 2
+
+/*
+ * One decoded LED. The layout matches a record of the binary export, so
+ * 32 bytes with natural alignment and no padding.
+ */
+typedef struct AsyncRgbLedRecord
+{
+    uint64_t start_sample;
+    uint64_t end_sample;
+    uint32_t packet;
+    uint32_t index;
+    uint16_t red;
+    uint16_t green;
+    uint16_t blue;
+    uint16_t reserved;
+} AsyncRgbLedRecord;
+
+typedef struct AsyncRgbLedDecoder AsyncRgbLedDecoder;
+
+/* the controller table, in the order of the analyzer's controller setting */
+ASYNCRGBLED_API size_t asyncrgbled_controller_count( void );
+ASYNCRGBLED_API const char* asyncrgbled_controller_name( size_t controller );
+
+/* returns NULL if the controller or sample rate is invalid */
+ASYNCRGBLED_API AsyncRgbLedDecoder* asyncrgbled_create( size_t controller, uint32_t sample_rate_hz );
+ASYNCRGBLED_API void asyncrgbled_destroy( AsyncRgbLedDecoder* decoder );
+
+/* the most records asyncrgbled_decode() can produce from edge_count edges */
+ASYNCRGBLED_API size_t asyncrgbled_max_records( const AsyncRgbLedDecoder* decoder, size_t edge_count );
+
+/*
+ * Decode the sample numbers of every transition of a capture. The line is
+ * low from sample zero to the first edge, and from the last falling edge
+ * to idle_sample, which ends the final packet if it's long enough for a
+ * reset. Packets are numbered from zero within each call.
+ *
+ * Up to max_records records are written, and *record_count is set to the
+ * number written.
+ */
+ASYNCRGBLED_API int asyncrgbled_decode( AsyncRgbLedDecoder* decoder,
+                                        const uint64_t* edges, size_t edge_count, uint64_t idle_sample,
+                                        AsyncRgbLedRecord* records, size_t max_records, size_t* record_count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* of #define ASYNCRGBLED_C_API */
@@ -0,0 +1,560 @@
+// asyncrgbled-decode - decode LED data from a capture file, without the
+// Logic software. Uses the same controller table, decoder and export
+// formats as the analyzer plugin.
+
+#include "AsyncRgbLedBitstream.h"
+#include "AsyncRgbLedControllers.h"
+#include "AsyncRgbLedDecoder.h"
+#include "AsyncRgbLedExport.h"
+#include "AsyncRgbLedHelpers.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // edges found in a bitstream before they are pushed to the decoder
+    const size_t SCAN_EDGES = 4096;
+
+    enum InputFormat
+    {
+        INPUT_BITSTREAM,
+        INPUT_EDGES
+    };
+
+    struct Options
+    {
+        std::string mInputPath;
+        std::string mOutputPath;
+        InputFormat mInputFormat = INPUT_BITSTREAM;
+        bool mIsBinaryOutput = false;
+        bool mIsInitialHigh = false;
+        size_t mController = 0;
+        U32 mSampleRateHz = 0;
+    };
+
+    void PrintUsage( const char* program )
+    {
+        std::cerr << "usage: " << program << " --controller NAME --rate HZ [options] CAPTURE\n"
+                  "\n"
+                  "  -c, --controller NAME   LED controller, one of:";
+
+        for ( size_t i = 0; i < LED_CONTROLLER_COUNT; ++i )
+        {
+            std::cerr << ( i == 0 ? " " : ", " ) << GetLedControllerData( i ).mName;
+        }
+
+        std::cerr << "\n"
+                  "  -r, --rate HZ           sample rate of the capture\n"
+                  "  -i, --input FORMAT      'bits': one bit per sample, packed LSB first into\n"
+                  "                          little-endian 64-bit words (the default)\n"
+                  "                          'edges': little-endian 64-bit sample numbers of\n"
+                  "                          every transition, with the line low before the first\n"
+                  "      --initial-high      with 'edges', the line is high before the first\n"
+                  "  -f, --format FORMAT     'csv' (the default) or 'binary'\n"
+                  "  -o, --output FILE       write to FILE rather than standard output; needed\n"
+                  "                          for binary output\n";
+    }
+
+    bool FindController( const char* name, size_t& index )
+    {
+        for ( size_t i = 0; i < LED_CONTROLLER_COUNT; ++i )
+        {
+            if ( strcasecmp( name, GetLedControllerData( i ).mName ) == 0 )
+            {
+                index = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// a whole number of Hz, so "24M" is refused rather than read as 24
+    bool ParseSampleRate( const char* text, U32& rateHz )
+    {
+        if ( ( *text < '0' ) || ( *text > '9' ) )
+        {
+            return false;
+        }
+
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long rate = std::strtoull( text, &end, 10 );
+
+        if ( ( *end != '\0' ) || ( errno == ERANGE ) || ( rate > std::numeric_limits<U32>::max() ) )
+        {
+            return false;
+        }
+
+        rateHz = static_cast<U32>( rate );
+        return true;
+    }
+
+    bool ParseOptions( int argc, char* argv[], Options& options )
+    {
+        enum
+        {
+            OPTION_INITIAL_HIGH = 256
+        };
+
+        const option longOptions[] =
+        {
+            {"controller", required_argument, nullptr, 'c'},
+            {"rate", required_argument, nullptr, 'r'},
+            {"input", required_argument, nullptr, 'i'},
+            {"initial-high", no_argument, nullptr, OPTION_INITIAL_HIGH},
+            {"format", required_argument, nullptr, 'f'},
+            {"output", required_argument, nullptr, 'o'},
+            {"help", no_argument, nullptr, 'h'},
+            {nullptr, 0, nullptr, 0}
+        };
+
+        bool hasController = false;
+        int opt;
+
+        while ( ( opt = getopt_long( argc, argv, "c:r:i:f:o:h", longOptions, nullptr ) ) != -1 )
+        {
+            switch ( opt )
+            {
+                case 'c':
+                    if ( !FindController( optarg, options.mController ) )
+                    {
+                        std::cerr << "unknown controller: " << optarg << std::endl;
+                        return false;
+                    }
+
+                    hasController = true;
+                    break;
+
+                case 'r':
+                    if ( !ParseSampleRate( optarg, options.mSampleRateHz ) )
+                    {
+                        std::cerr << "bad sample rate, expected a number of Hz: " << optarg << std::endl;
+                        return false;
+                    }
+
+                    break;
+
+                case 'i':
+                    if ( std::strcmp( optarg, "bits" ) == 0 )
+                    {
+                        options.mInputFormat = INPUT_BITSTREAM;
+                    }
+                    else if ( std::strcmp( optarg, "edges" ) == 0 )
+                    {
+                        options.mInputFormat = INPUT_EDGES;
+                    }
+                    else
+                    {
+                        std::cerr << "unknown input format: " << optarg << std::endl;
+                        return false;
+                    }
+
+                    break;
+
+                case OPTION_INITIAL_HIGH:
+                    options.mIsInitialHigh = true;
+                    break;
+
+                case 'f':
+                    if ( std::strcmp( optarg, "csv" ) == 0 )
+                    {
+                        options.mIsBinaryOutput = false;
+                    }
+                    else if ( std::strcmp( optarg, "binary" ) == 0 )
+                    {
+                        options.mIsBinaryOutput = true;
+                    }
+                    else
+                    {
+                        std::cerr << "unknown output format: " << optarg << std::endl;
+                        return false;
+                    }
+
+                    break;
+
+                case 'o':
+                    options.mOutputPath = optarg;
+                    break;
+
+                default:
+                    return false;
+            }
+        }
+
+        if ( optind + 1 != argc )
+        {
+            return false;
+        }
+
+        options.mInputPath = argv[optind];
+
+        if ( !hasController || ( options.mSampleRateHz == 0 ) )
+        {
+            std::cerr << "a controller and sample rate are needed" << std::endl;
+            return false;
+        }
+
+        if ( options.mIsBinaryOutput && options.mOutputPath.empty() )
+        {
+            // the header is rewritten once the record count is known
+            std::cerr << "binary output needs an output file" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    /// read-only mapping of a whole file
+    class MappedFile
+    {
+        public:
+            MappedFile() = default;
+
+            ~MappedFile()
+            {
+                if ( mData != nullptr )
+                {
+                    munmap( mData, mSize );
+                }
+            }
+
+            MappedFile( const MappedFile& ) = delete;
+            MappedFile& operator=( const MappedFile& ) = delete;
+
+            bool Open( const std::string& path )
+            {
+                const int fd = open( path.c_str(), O_RDONLY );
+
+                if ( fd < 0 )
+                {
+                    return false;
+                }
+
+                struct stat info;
+                bool isMapped = ( fstat( fd, &info ) == 0 );
+                mSize = isMapped ? static_cast<size_t>( info.st_size ) : 0;
+
+                // an empty capture has nothing to map
+                if ( isMapped && ( mSize > 0 ) )
+                {
+                    mData = mmap( nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+                    isMapped = ( mData != MAP_FAILED );
+
+                    if ( isMapped )
+                    {
+                        // captures are read once, front to back
+                        madvise( mData, mSize, MADV_SEQUENTIAL );
+                    }
+                    else
+                    {
+                        mData = nullptr;
+                    }
+                }
+
+                close( fd );
+                return isMapped;
+            }
+
+            const U8* Data() const
+            {
+                return static_cast<const U8*>( mData );
+            }
+
+            size_t Size() const
+            {
+                return mSize;
+            }
+
+        private:
+            void* mData = nullptr;
+            size_t mSize = 0;
+    };
+
+    /// writes decoded LEDs in the analyzer's CSV or binary export format
+    class ExportOutput : public DecoderOutput
+    {
+        public:
+            ExportOutput( std::ostream& out, const Options& options, const LedControllerData& controller ) :
+                mOut( out ),
+                mBuffer( out ),
+                mIsBinary( options.mIsBinaryOutput ),
+                mSampleRateHz( options.mSampleRateHz ),
+                mBitSize( controller.mBitsPerChannel )
+            {
+                mHeader = {};
+                std::copy( BINARY_EXPORT_MAGIC, BINARY_EXPORT_MAGIC + sizeof( mHeader.mMagic ), mHeader.mMagic );
+                mHeader.mVersion = BINARY_EXPORT_VERSION;
+                mHeader.mHeaderSize = sizeof( BinaryExportHeader );
+                mHeader.mController = static_cast<U32>( options.mController );
+                mHeader.mBitSize = controller.mBitsPerChannel;
+                mHeader.mChannelCount = controller.mChannelCount;
+                mHeader.mSampleRateHz = options.mSampleRateHz;
+                mHeader.mRecordSize = sizeof( BinaryExportRecord );
+                mHeader.mRecordsOffset = sizeof( BinaryExportHeader );
+
+                if ( mIsBinary )
+                {
+                    mBuffer.AppendRaw( mHeader );
+                }
+                else
+                {
+                    mBuffer.Append( "Time [s], Packet ID, LED Index, Red, Green, Blue, Web-CSS\n" );
+                }
+            }
+
+            void StartPacket() override
+            {
+                ++mPacketSequence;
+                mLedIndex = 0;
+            }
+
+            void AddLed( const RGBValue& rgb, U64 beginSample, U64 endSample, bool ) override
+            {
+                const U32 packetId = mPacketSequence - 1;
+                const U32 ledIndex = mLedIndex++;
+
+                if ( mIsBinary )
+                {
+                    BinaryExportRecord record = {};
+                    record.mStartSample = beginSample;
+                    record.mEndSample = endSample;
+                    record.mPacketId = packetId;
+                    record.mLedIndex = ledIndex;
+                    record.mRed = rgb.red;
+                    record.mGreen = rgb.green;
+                    record.mBlue = rgb.blue;
+                    mBuffer.AppendRaw( record );
+
+                    if ( mPackets.empty() || ( mPackets.back().mPacketId != packetId ) )
+                    {
+                        mPackets.push_back( BinaryExportPacket{mRecordCount, packetId, 0} );
+                    }
+
+                    ++mPackets.back().mRecordCount;
+                    ++mRecordCount;
+                    return;
+                }
+
+                mBuffer.AppendTime( beginSample, 0, mSampleRateHz );
+                mBuffer.Append( ',' );
+                mBuffer.AppendDecimal( packetId );
+                mBuffer.Append( ',' );
+                mBuffer.AppendDecimal( ledIndex );
+
+                for ( const U16 channel : {rgb.red, rgb.green, rgb.blue} )
+                {
+                    mBuffer.Append( ',' );
+                    mBuffer.AppendDecimal( channel );
+                }
+
+                U8 webColor[3];
+                rgb.ConvertTo8Bit( mBitSize, webColor );
+                mBuffer.Append( ',' );
+                mBuffer.AppendWebColor( webColor );
+                mBuffer.Append( '\n' );
+            }
+
+            void EndPacket( bool, U64 ) override
+            {
+            }
+
+            void Finish()
+            {
+                if ( mIsBinary )
+                {
+                    for ( const auto& packet : mPackets )
+                    {
+                        mBuffer.AppendRaw( packet );
+                    }
+                }
+
+                mBuffer.Flush();
+
+                if ( mIsBinary )
+                {
+                    mHeader.mRecordCount = mRecordCount;
+                    mHeader.mPacketCount = mPackets.size();
+                    mHeader.mPacketTableOffset = mHeader.mRecordsOffset + mRecordCount * sizeof( BinaryExportRecord );
+                    mOut.seekp( 0 );
+                    mOut.write( reinterpret_cast<const char*>( &mHeader ), sizeof( mHeader ) );
+                }
+
+                mOut.flush();
+            }
+
+        private:
+            std::ostream& mOut;
+            ExportBuffer mBuffer;
+            const bool mIsBinary;
+            const U32 mSampleRateHz;
+            const U8 mBitSize;
+
+            U32 mPacketSequence = 0;
+            U32 mLedIndex = 0;
+
+            BinaryExportHeader mHeader;
+            std::vector<BinaryExportPacket> mPackets;
+            U64 mRecordCount = 0;
+    };
+
+    /// finds the first edge earlier than the one before it, which the decoder
+    /// only asserts against
+    bool FindEdgeOutOfOrder( const U64* edges, size_t edgeCount, size_t& index )
+    {
+        for ( size_t i = 1; i < edgeCount; ++i )
+        {
+            if ( edges[i] < edges[i - 1] )
+            {
+                index = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void DecodeEdges( const MappedFile& capture, const Options& options, const DecoderTiming& timing,
+                      LedDecoder& decoder, DecoderOutput& output )
+    {
+        // the file is page-aligned, so the sample numbers are read in place
+        const U64* edges = reinterpret_cast<const U64*>( capture.Data() );
+        size_t edgeCount = capture.Size() / sizeof( U64 );
+        U64 startSample = 0;
+
+        if ( options.mIsInitialHigh && ( edgeCount > 0 ) )
+        {
+            // start decoding at the first falling edge
+            startSample = edges[0];
+            ++edges;
+            --edgeCount;
+        }
+
+        decoder.Start( startSample, &output );
+        decoder.Push( edges, edgeCount );
+
+        // the line is taken to stay at its last level after the capture ends
+        const U64 lastSample = ( edgeCount > 0 ) ? edges[edgeCount - 1] : startSample;
+        decoder.Idle( lastSample + timing.mResetSamples );
+    }
+
+    void DecodeBitstream( const MappedFile& capture, LedDecoder& decoder, DecoderOutput& output )
+    {
+        PackedEdgeScanner scanner( capture.Data(), static_cast<U64>( capture.Size() ) * 8 );
+        std::vector<U64> edges( SCAN_EDGES );
+        size_t count = scanner.Next( edges.data(), edges.size() );
+        size_t first = 0;
+
+        if ( scanner.InitialLevel() == BIT_HIGH )
+        {
+            if ( count == 0 )
+            {
+                // high for the whole capture
+                return;
+            }
+
+            // start decoding at the first falling edge
+            first = 1;
+        }
+
+        decoder.Start( ( first > 0 ) ? edges[0] : 0, &output );
+
+        for ( ; count > 0; count = scanner.Next( edges.data(), edges.size() ) )
+        {
+            decoder.Push( edges.data() + first, count - first );
+            first = 0;
+        }
+
+        decoder.Idle( scanner.SampleCount() );
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    Options options;
+
+    if ( !ParseOptions( argc, argv, options ) )
+    {
+        PrintUsage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    MappedFile capture;
+
+    if ( !capture.Open( options.mInputPath ) )
+    {
+        std::cerr << "can't read " << options.mInputPath << ": " << std::strerror( errno ) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if ( ( options.mInputFormat == INPUT_EDGES ) && ( ( capture.Size() % sizeof( U64 ) ) != 0 ) )
+    {
+        std::cerr << options.mInputPath << " isn't a whole number of 64-bit edges" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t outOfOrderEdge = 0;
+
+    if ( ( options.mInputFormat == INPUT_EDGES ) &&
+            FindEdgeOutOfOrder( reinterpret_cast<const U64*>( capture.Data() ), capture.Size() / sizeof( U64 ), outOfOrderEdge ) )
+    {
+        std::cerr << options.mInputPath << ": edge " << outOfOrderEdge << " is earlier than the edge before it" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream outputFile;
+
+    if ( !options.mOutputPath.empty() )
+    {
+        outputFile.open( options.mOutputPath, std::ios::out | std::ios::binary | std::ios::trunc );
+
+        if ( !outputFile )
+        {
+            std::cerr << "can't write " << options.mOutputPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ostream& out = options.mOutputPath.empty() ? std::cout : outputFile;
+
+    const LedControllerData& controller = GetLedControllerData( options.mController );
+    const DecoderTiming timing = CreateDecoderTiming( controller, options.mSampleRateHz );
+    std::unique_ptr<LedDecoder> decoder = LedDecoder::Create( timing, controller.mBitsPerChannel, controller.mLayout );
+
+    ExportOutput output( out, options, controller );
+
+    if ( options.mInputFormat == INPUT_EDGES )
+    {
+        DecodeEdges( capture, options, timing, *decoder, output );
+    }
+    else
+    {
+        DecodeBitstream( capture, *decoder, output );
+    }
+
+    output.Finish();
+
+    if ( !out )
+    {
+        std::cerr << "error writing the output" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}